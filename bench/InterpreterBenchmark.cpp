@@ -0,0 +1,66 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/Lox/Arena.h"
+#include "../src/Lox/Interpreter.h"
+#include "../src/Lox/Jit.h"
+#include "../src/Lox/Optimizer.h"
+#include "../src/Lox/Parser.h"
+#include "../src/Lox/Resolver.h"
+#include "../src/Lox/Scanner.h"
+#include "Workloads.h"
+
+namespace {
+
+using lox::bench::Workload;
+
+// Parses, resolves and optimizes `source` the way Lox::run does, keeping
+// the tree in `arena`.
+std::vector<lox::parser::Statement*> compile(lox::lang::Resolver& resolver,
+                                             lox::parser::Arena& arena,
+                                             const std::string& source) {
+  auto scanner = lox::parser::Scanner(source);
+  auto statements = lox::parser::Parser(scanner, arena).parse();
+  resolver.resolve(statements);
+  lox::lang::Optimizer(arena).optimize(statements);
+  return statements;
+}
+
+// Runs the setup of the workload once, then times its run part, on a
+// warm interpreter: inline caches are filled, binary operators quickened
+// and, with a nonzero JIT threshold, hot functions compiled. The first
+// argument is the JIT threshold.
+void BM_Evaluate(benchmark::State& state, const Workload& workload) {
+  auto interpreter = std::make_shared<lox::lang::Interpreter>();
+  interpreter->setJitThreshold(state.range(0));
+  auto resolver = lox::lang::Resolver(interpreter);
+  lox::parser::Arena arena;
+  std::string setup(workload.setup);
+  std::string run(workload.run);
+
+  interpreter->evaluate(compile(resolver, arena, setup));
+  auto statements = compile(resolver, arena, run);
+  for (auto _ : state) {
+    interpreter->evaluate(statements);
+  }
+}
+
+#define LOX_BENCHMARK_EVALUATE(name, workload)     \
+  BENCHMARK_CAPTURE(BM_Evaluate, name, workload)   \
+      ->ArgName("jit_threshold")                   \
+      ->Arg(0)                                     \
+      ->Arg(lox::lang::Jit::kDefaultThreshold)     \
+      ->Unit(benchmark::kMicrosecond)
+
+LOX_BENCHMARK_EVALUATE(fib, lox::bench::kFib);
+LOX_BENCHMARK_EVALUATE(loops, lox::bench::kLoops);
+LOX_BENCHMARK_EVALUATE(strings, lox::bench::kStrings);
+LOX_BENCHMARK_EVALUATE(report, lox::bench::kReport);
+LOX_BENCHMARK_EVALUATE(classes, lox::bench::kClasses);
+LOX_BENCHMARK_EVALUATE(methods, lox::bench::kMethods);
+LOX_BENCHMARK_EVALUATE(closures, lox::bench::kClosures);
+
+}  // namespace
@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/Lox/Arena.h"
+#include "../src/Lox/Interpreter.h"
+#include "../src/Lox/Parser.h"
+#include "../src/Lox/Resolver.h"
+#include "../src/Lox/Scanner.h"
+#include "Workloads.h"
+
+namespace {
+
+using lox::bench::Workload;
+
+void BM_Parse(benchmark::State& state, const Workload& workload) {
+  auto source = workload.source();
+  auto tokens = lox::parser::Scanner(source).scanTokens();
+  for (auto _ : state) {
+    lox::parser::Arena arena;
+    auto statements = lox::parser::Parser(tokens, arena).parse();
+    benchmark::DoNotOptimize(statements.data());
+  }
+  state.SetBytesProcessed(state.iterations() * source.size());
+}
+BENCHMARK_CAPTURE(BM_Parse, fib, lox::bench::kFib);
+BENCHMARK_CAPTURE(BM_Parse, loops, lox::bench::kLoops);
+BENCHMARK_CAPTURE(BM_Parse, strings, lox::bench::kStrings);
+BENCHMARK_CAPTURE(BM_Parse, classes, lox::bench::kClasses);
+BENCHMARK_CAPTURE(BM_Parse, methods, lox::bench::kMethods);
+BENCHMARK_CAPTURE(BM_Parse, closures, lox::bench::kClosures);
+
+// The resolver annotates the tree it resolves and declares its globals,
+// so every iteration resolves a fresh tree with a fresh resolver. Only the
+// resolve() call is timed.
+void BM_Resolve(benchmark::State& state, const Workload& workload) {
+  auto source = workload.source();
+  auto tokens = lox::parser::Scanner(source).scanTokens();
+  for (auto _ : state) {
+    lox::parser::Arena arena;
+    auto statements = lox::parser::Parser(tokens, arena).parse();
+    auto resolver = lox::lang::Resolver(
+        std::make_shared<lox::lang::Interpreter>());
+
+    auto start = std::chrono::steady_clock::now();
+    resolver.resolve(statements);
+    auto end = std::chrono::steady_clock::now();
+    state.SetIterationTime(
+        std::chrono::duration<double>(end - start).count());
+  }
+  state.SetBytesProcessed(state.iterations() * source.size());
+}
+BENCHMARK_CAPTURE(BM_Resolve, fib, lox::bench::kFib)->UseManualTime();
+BENCHMARK_CAPTURE(BM_Resolve, loops, lox::bench::kLoops)->UseManualTime();
+BENCHMARK_CAPTURE(BM_Resolve, strings, lox::bench::kStrings)->UseManualTime();
+BENCHMARK_CAPTURE(BM_Resolve, classes, lox::bench::kClasses)->UseManualTime();
+BENCHMARK_CAPTURE(BM_Resolve, methods, lox::bench::kMethods)->UseManualTime();
+BENCHMARK_CAPTURE(BM_Resolve, closures, lox::bench::kClosures)
+    ->UseManualTime();
+
+}  // namespace
@@ -0,0 +1,82 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <string_view>
+
+#include "../src/Lox/Scanner.h"
+#include "Workloads.h"
+
+namespace {
+
+constexpr std::string_view kProgram =
+    "// Shapes and counters.\n"
+    "class Shape {\n"
+    "  init(name, sides) { this.name = name; this.sides = sides; }\n"
+    "  describe() { return this.name + \" with \" + this.sides; }\n"
+    "}\n"
+    "class Square < Shape {\n"
+    "  init(size) { super.init(\"square\", 4); this.size = size; }\n"
+    "  area() { return this.size * this.size; }\n"
+    "}\n"
+    "fun makeCounter(start) {\n"
+    "  var count = start;\n"
+    "  fun increment() { count = count + 1; return count; }\n"
+    "  return increment;\n"
+    "}\n"
+    "var total = 0;\n"
+    "for (var index = 0; index < 100; index = index + 1) {\n"
+    "  if (index == 50 or total > 1000.5) continue;\n"
+    "  while (total < index and !false) { total = total + index / 2; }\n"
+    "}\n"
+    "var square = Square(12.25);\n"
+    "print square.describe();\n"
+    "print makeCounter(nil == nil)();\n";
+
+constexpr std::string_view kIdentifiers =
+    "alpha beta gamma delta epsilon and or class fun var while for if else\n"
+    "returnValue superclass thisOne trueish falsey nilable printer lambda\n"
+    "break continue counter index value result left right node next\n";
+
+std::string repeat(std::string_view text, size_t bytes) {
+  std::string source;
+  source.reserve(bytes + text.size());
+  while (source.size() < bytes) {
+    source += text;
+  }
+  return source;
+}
+
+void scan(benchmark::State& state, std::string_view text) {
+  auto source = repeat(text, state.range(0));
+  for (auto _ : state) {
+    auto scanner = lox::parser::Scanner(source);
+    auto tokens = scanner.scanTokens();
+    benchmark::DoNotOptimize(tokens.data());
+  }
+  state.SetBytesProcessed(state.iterations() * source.size());
+}
+
+void BM_ScanProgram(benchmark::State& state) { scan(state, kProgram); }
+BENCHMARK(BM_ScanProgram)->Arg(64 << 10)->Arg(1 << 20);
+
+void BM_ScanIdentifiers(benchmark::State& state) {
+  scan(state, kIdentifiers);
+}
+BENCHMARK(BM_ScanIdentifiers)->Arg(64 << 10)->Arg(1 << 20);
+
+void BM_ScanWorkload(benchmark::State& state,
+                     const lox::bench::Workload& workload) {
+  scan(state, workload.source());
+}
+BENCHMARK_CAPTURE(BM_ScanWorkload, fib, lox::bench::kFib)->Arg(64 << 10);
+BENCHMARK_CAPTURE(BM_ScanWorkload, loops, lox::bench::kLoops)->Arg(64 << 10);
+BENCHMARK_CAPTURE(BM_ScanWorkload, strings, lox::bench::kStrings)
+    ->Arg(64 << 10);
+BENCHMARK_CAPTURE(BM_ScanWorkload, classes, lox::bench::kClasses)
+    ->Arg(64 << 10);
+BENCHMARK_CAPTURE(BM_ScanWorkload, methods, lox::bench::kMethods)
+    ->Arg(64 << 10);
+BENCHMARK_CAPTURE(BM_ScanWorkload, closures, lox::bench::kClosures)
+    ->Arg(64 << 10);
+
+}  // namespace
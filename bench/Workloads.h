@@ -0,0 +1,97 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+namespace lox {
+namespace bench {
+
+// A canonical Lox program. `setup` declares the functions and classes the
+// program needs, `run` is the part worth timing again and again. Neither
+// prints, results are left in globals.
+struct Workload {
+  std::string_view setup;
+  std::string_view run;
+
+  std::string source() const {
+    return std::string(setup) + std::string(run);
+  }
+};
+
+constexpr Workload kFib{
+    "fun fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n",
+    "var result = fib(20);\n"};
+
+constexpr Workload kLoops{
+    "",
+    "var sum = 0;\n"
+    "var i = 0;\n"
+    "while (i < 10000) {\n"
+    "  i = i + 1;\n"
+    "  if (i / 3 == 7) continue;\n"
+    "  sum = sum + (i > 5000 ? i * 2 : i - 1);\n"
+    "}\n"
+    "for (var j = 0; j < 10000; j = j + 1) sum = sum - j;\n"};
+
+constexpr Workload kStrings{
+    "",
+    "var text = \"\";\n"
+    "for (var i = 0; i < 500; i = i + 1) {\n"
+    "  text = text + \"item \" + i + \", \";\n"
+    "}\n"};
+
+// Builds a long string piece by piece and compares it once at the end.
+constexpr Workload kReport{
+    "",
+    "var report = \"\";\n"
+    "for (var i = 0; i < 20000; i = i + 1) {\n"
+    "  report = report + \"row \" + i + \": ok; \";\n"
+    "}\n"
+    "var same = report + \"\" == report;\n"};
+
+constexpr Workload kClasses{
+    "class Point {\n"
+    "  init(x, y) { this.x = x; this.y = y; }\n"
+    "}\n"
+    "class Point3 < Point {\n"
+    "  init(x, y, z) { super.init(x, y); this.z = z; }\n"
+    "}\n",
+    "var last;\n"
+    "for (var i = 0; i < 1000; i = i + 1) {\n"
+    "  last = Point(i, i + 1);\n"
+    "  last = Point3(i, i + 1, i + 2);\n"
+    "}\n"};
+
+constexpr Workload kMethods{
+    "class Counter {\n"
+    "  init() { this.count = 0; }\n"
+    "  add(n) { this.count = this.count + n; return this; }\n"
+    "  get() { return this.count; }\n"
+    "}\n"
+    "class Twice < Counter {\n"
+    "  add(n) { return super.add(2 * n); }\n"
+    "}\n"
+    "var counter = Counter();\n"
+    "var twice = Twice();\n",
+    "for (var i = 0; i < 1000; i = i + 1) {\n"
+    "  counter.add(i).add(1);\n"
+    "  twice.add(i);\n"
+    "}\n"
+    "var total = counter.get() + twice.get();\n"};
+
+constexpr Workload kClosures{
+    "fun makeAdder(n) {\n"
+    "  fun add(x) { return x + n; }\n"
+    "  return add;\n"
+    "}\n"
+    "fun makeCounter() {\n"
+    "  var count = 0;\n"
+    "  return lambda() { count = count + 1; return count; };\n"
+    "}\n",
+    "var sum = 0;\n"
+    "var counter = makeCounter();\n"
+    "for (var i = 0; i < 1000; i = i + 1) {\n"
+    "  sum = sum + makeAdder(i)(1) + counter();\n"
+    "}\n"};
+
+}  // namespace bench
+}  // namespace lox
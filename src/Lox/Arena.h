@@ -0,0 +1,118 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lox {
+namespace parser {
+
+// Fixed size array living in an Arena.
+template <typename T>
+class Span {
+ public:
+  Span() : data_(nullptr), size_(0) {}
+  Span(T* data, uint32_t size) : data_(data), size_(size) {}
+
+  T* begin() const { return data_; }
+  T* end() const { return data_ + size_; }
+  T& operator[](size_t i) const { return data_[i]; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+ private:
+  T* data_;
+  uint32_t size_;
+};
+
+// Bump allocator owning the nodes of a parsed program. Nodes are carved out
+// of large blocks and all of them are released at once when the arena is
+// destroyed, so building the tree costs a pointer bump per node instead of
+// a heap allocation and a reference count.
+class Arena {
+ public:
+  Arena() : cursor_(nullptr), end_(nullptr), bytes_(0) {}
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  ~Arena() {
+    for (auto it = destructors_.rbegin(); it != destructors_.rend(); ++it) {
+      it->destroy(it->object, it->count);
+    }
+  }
+
+  template <typename T, typename... Args>
+  T* make(Args&&... args) {
+    T* object = new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+    registerDestructor(object, 1);
+    return object;
+  }
+
+  template <typename T>
+  Span<T> list(std::vector<T>&& items) {
+    if (items.empty()) {
+      return Span<T>();
+    }
+    T* data = static_cast<T*>(allocate(sizeof(T) * items.size(), alignof(T)));
+    for (size_t i = 0; i < items.size(); i++) {
+      new (data + i) T(std::move(items[i]));
+    }
+    registerDestructor(data, items.size());
+    return Span<T>(data, items.size());
+  }
+
+  // Total bytes handed out to nodes.
+  size_t bytesAllocated() const { return bytes_; }
+
+ private:
+  static constexpr size_t kBlockSize = 32 * 1024;
+
+  struct Destructor {
+    void* object;
+    size_t count;
+    void (*destroy)(void* object, size_t count);
+  };
+
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  std::vector<Destructor> destructors_;
+  char* cursor_;
+  char* end_;
+  size_t bytes_;
+
+  void* allocate(size_t size, size_t align) {
+    auto address = reinterpret_cast<uintptr_t>(cursor_);
+    size_t padding = (align - address % align) % align;
+    if (!cursor_ || padding + size > static_cast<size_t>(end_ - cursor_)) {
+      size_t blockSize = std::max(kBlockSize, size + align);
+      blocks_.emplace_back(new char[blockSize]);
+      cursor_ = blocks_.back().get();
+      end_ = cursor_ + blockSize;
+      address = reinterpret_cast<uintptr_t>(cursor_);
+      padding = (align - address % align) % align;
+    }
+    void* result = cursor_ + padding;
+    cursor_ += padding + size;
+    bytes_ += size;
+    return result;
+  }
+
+  template <typename T>
+  void registerDestructor(T* object, size_t count) {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      destructors_.push_back({object, count, [](void* p, size_t n) {
+                                auto objects = static_cast<T*>(p);
+                                for (size_t i = 0; i < n; i++) {
+                                  objects[i].~T();
+                                }
+                              }});
+    }
+  }
+};
+
+}  // namespace parser
+}  // namespace lox
@@ -2,88 +2,96 @@
 
 #include <sstream>
 #include <string>
+#include <string_view>
 
+#include "LoxString.h"
 #include "utils.h"
 
 namespace lox {
 namespace parser {
 
-std::string AstPrinter::print(const std::shared_ptr<Expression>& expr) {
-  return lox::util::any_to_string(expr->accept(this));
+namespace {
+lox::lang::Value toValue(std::string_view str) {
+  return lox::lang::makeObject<lox::lang::LoxString>(std::string(str));
 }
-std::string AstPrinter::print(const std::shared_ptr<Statement>& stmt) {
-  return lox::util::any_to_string(stmt->accept(this));
+}  // namespace
+
+std::string AstPrinter::print(const Expression* expr) {
+  return lox::util::to_string(expr->accept(this));
+}
+std::string AstPrinter::print(const Statement* stmt) {
+  return lox::util::to_string(stmt->accept(this));
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const Binary> expr) {
+lox::lang::Value AstPrinter::visit(const Binary* expr) {
   std::stringstream ss;
   ss << "( " << expr->op.lexeme << " "
-     << lox::util::any_to_string(expr->left->accept(this)) << " "
-     << lox::util::any_to_string(expr->right->accept(this)) << ")";
-  return ss.str();
+     << lox::util::to_string(expr->left->accept(this)) << " "
+     << lox::util::to_string(expr->right->accept(this)) << ")";
+  return toValue(ss.str());
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const Grouping> expr) {
+lox::lang::Value AstPrinter::visit(const Grouping* expr) {
   std::stringstream ss;
-  ss << "(" << lox::util::any_to_string(expr->expression->accept(this)) << ")";
-  return ss.str();
+  ss << "(" << lox::util::to_string(expr->expression->accept(this)) << ")";
+  return toValue(ss.str());
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const Unary> expr) {
+lox::lang::Value AstPrinter::visit(const Unary* expr) {
   std::stringstream ss;
   ss << "(" << expr->op.lexeme << " "
-     << lox::util::any_to_string(expr->right->accept(this)) << ")";
-  return ss.str();
+     << lox::util::to_string(expr->right->accept(this)) << ")";
+  return toValue(ss.str());
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const Literal> expr) {
-  return lox::util::any_to_string(expr->value);
+lox::lang::Value AstPrinter::visit(const Literal* expr) {
+  return toValue(lox::util::to_string(expr->value));
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const Variable> expr) {
-  return expr->token.lexeme;
+lox::lang::Value AstPrinter::visit(const Variable* expr) {
+  return toValue(expr->token.lexeme);
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const Sequence> expr) {
+lox::lang::Value AstPrinter::visit(const Sequence* expr) {
   std::stringstream ss;
   ss << "(";
   for (const auto& expr : expr->expressions) {
-    ss << lox::util::any_to_string(expr->accept(this)) << ", ";
+    ss << lox::util::to_string(expr->accept(this)) << ", ";
   }
   ss << ")";
-  return ss.str();
+  return toValue(ss.str());
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const Ternary> expr) {
+lox::lang::Value AstPrinter::visit(const Ternary* expr) {
   std::stringstream ss;
-  ss << "(? (" << lox::util::any_to_string(expr->predicate->accept(this))
-     << ") " << lox::util::any_to_string(expr->then->accept(this));
+  ss << "(? (" << lox::util::to_string(expr->predicate->accept(this))
+     << ") " << lox::util::to_string(expr->then->accept(this));
   if (expr->alternative) {
-    ss << " : " << lox::util::any_to_string(expr->alternative->accept(this));
+    ss << " : " << lox::util::to_string(expr->alternative->accept(this));
   }
   ss << ")";
-  return ss.str();
+  return toValue(ss.str());
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const Assignment> expr) {
+lox::lang::Value AstPrinter::visit(const Assignment* expr) {
   std::stringstream ss;
   ss << "(assign " << expr->token.lexeme << " "
-     << lox::util::any_to_string(expr->target->accept(this)) << ")";
-  return ss.str();
+     << lox::util::to_string(expr->target->accept(this)) << ")";
+  return toValue(ss.str());
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const Call> expr) {
+lox::lang::Value AstPrinter::visit(const Call* expr) {
   std::stringstream ss;
-  ss << "(call " << lox::util::any_to_string(expr->callee->accept(this)) << " ";
+  ss << "(call " << lox::util::to_string(expr->callee->accept(this)) << " ";
   if (expr->arguments) {
-    ss << lox::util::any_to_string(expr->arguments->accept(this));
+    ss << lox::util::to_string(expr->arguments->accept(this));
   }
   ss << ")";
 
-  return ss.str();
+  return toValue(ss.str());
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const Lambda> expr) {
+lox::lang::Value AstPrinter::visit(const Lambda* expr) {
   std::stringstream ss;
   ss << "(lambda (";
   if (!expr->function->parameters.empty()) {
@@ -93,99 +101,101 @@ std::any AstPrinter::visit(std::shared_ptr<const Lambda> expr) {
   }
   ss << ") ";
   if (expr->function->body) {
-    ss << lox::util::any_to_string(expr->function->body->accept(this));
+    ss << lox::util::to_string(expr->function->body->accept(this));
   }
   ss << ")";
-  return ss.str();
+  return toValue(ss.str());
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const Get> expr) {
+lox::lang::Value AstPrinter::visit(const Get* expr) {
   std::stringstream ss;
-  ss << "(get " << lox::util::any_to_string(expr->object->accept(this)) << "->"
+  ss << "(get " << lox::util::to_string(expr->object->accept(this)) << "->"
      << expr->name.lexeme << ")";
-  return ss.str();
+  return toValue(ss.str());
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const Set> expr) {
+lox::lang::Value AstPrinter::visit(const Set* expr) {
   std::stringstream ss;
-  ss << "(set " << lox::util::any_to_string(expr->object->accept(this)) << "->"
-     << expr->name.lexeme << lox::util::any_to_string(expr->value->accept(this))
+  ss << "(set " << lox::util::to_string(expr->object->accept(this)) << "->"
+     << expr->name.lexeme << lox::util::to_string(expr->value->accept(this))
      << ")";
-  return ss.str();
+  return toValue(ss.str());
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const This> expr) {
-  return expr->token.lexeme;
+lox::lang::Value AstPrinter::visit(const This* expr) {
+  return toValue(expr->token.lexeme);
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const Super> expr) {
+lox::lang::Value AstPrinter::visit(const Super* expr) {
   std::stringstream ss;
   ss << "(" << expr->keyword.lexeme << "." << expr->method.lexeme << ")";
-  return ss.str();
+  return toValue(ss.str());
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const StatementExpression> stmt) {
+lox::lang::Value AstPrinter::visit(const StatementExpression* stmt) {
   std::stringstream ss;
-  ss << "(" << lox::util::any_to_string(stmt->expression->accept(this)) << ")";
-  return ss.str();
+  ss << "(" << lox::util::to_string(stmt->expression->accept(this)) << ")";
+  return toValue(ss.str());
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const Print> stmt) {
+lox::lang::Value AstPrinter::visit(const Print* stmt) {
   std::stringstream ss;
-  ss << "(print " << lox::util::any_to_string(stmt->expression->accept(this))
+  ss << "(print " << lox::util::to_string(stmt->expression->accept(this))
      << ")";
-  return ss.str();
+  return toValue(ss.str());
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const Var> stmt) {
+lox::lang::Value AstPrinter::visit(const Var* stmt) {
   std::stringstream ss;
   ss << "(define " << stmt->token.lexeme;
   if (stmt->initializer) {
-    ss << " = " << lox::util::any_to_string(stmt->initializer->accept(this));
+    ss << " = " << lox::util::to_string(stmt->initializer->accept(this));
   }
   ss << ")";
-  return ss.str();
+  return toValue(ss.str());
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const Block> stmt) {
+lox::lang::Value AstPrinter::visit(const Block* stmt) {
   std::stringstream ss;
   ss << "{ \n";
   for (const auto& s : stmt->statements) {
-    ss << lox::util::any_to_string(s->accept(this)) << "\n";
+    ss << lox::util::to_string(s->accept(this)) << "\n";
   }
   ss << "}";
-  return ss.str();
+  return toValue(ss.str());
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const If> stmt) {
+lox::lang::Value AstPrinter::visit(const If* stmt) {
   std::stringstream ss;
-  ss << "(if (" << lox::util::any_to_string(stmt->predicate->accept(this))
-     << ") " << lox::util::any_to_string(stmt->then->accept(this));
+  ss << "(if (" << lox::util::to_string(stmt->predicate->accept(this))
+     << ") " << lox::util::to_string(stmt->then->accept(this));
   if (stmt->alternative) {
-    ss << " else " << lox::util::any_to_string(stmt->alternative->accept(this));
+    ss << " else " << lox::util::to_string(stmt->alternative->accept(this));
   }
   ss << " )";
-  return ss.str();
+  return toValue(ss.str());
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const While> stmt) {
+lox::lang::Value AstPrinter::visit(const While* stmt) {
   std::stringstream ss;
-  ss << "(while (" << lox::util::any_to_string(stmt->condition->accept(this))
-     << ") {" << lox::util::any_to_string(stmt->body->accept(this)) << "}";
-  return ss.str();
+  ss << "(while ("
+     << (stmt->condition ? lox::util::to_string(stmt->condition->accept(this))
+                         : "true")
+     << ") {" << lox::util::to_string(stmt->body->accept(this)) << "}";
+  return toValue(ss.str());
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const Continue> stmt) {
-  return stmt->token.lexeme;
+lox::lang::Value AstPrinter::visit(const Continue* stmt) {
+  return toValue(stmt->token.lexeme);
 }
-std::any AstPrinter::visit(std::shared_ptr<const Break> stmt) {
-  return stmt->token.lexeme;
+lox::lang::Value AstPrinter::visit(const Break* stmt) {
+  return toValue(stmt->token.lexeme);
 }
-std::any AstPrinter::visit(std::shared_ptr<const Return> stmt) {
-  return stmt->token.lexeme;
+lox::lang::Value AstPrinter::visit(const Return* stmt) {
+  return toValue(stmt->token.lexeme);
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const Function> stmt) {
+lox::lang::Value AstPrinter::visit(const Function* stmt) {
   std::stringstream ss;
   ss << "(fun" << stmt->name.lexeme << "(";
   if (!stmt->parameters.empty()) {
@@ -195,28 +205,28 @@ std::any AstPrinter::visit(std::shared_ptr<const Function> stmt) {
   }
   ss << ") ";
   if (stmt->body) {
-    ss << lox::util::any_to_string(stmt->body->accept(this));
+    ss << lox::util::to_string(stmt->body->accept(this));
   }
   ss << ")";
-  return ss.str();
+  return toValue(ss.str());
 }
 
-std::any AstPrinter::visit(std::shared_ptr<const Class> stmt) {
+lox::lang::Value AstPrinter::visit(const Class* stmt) {
   std::stringstream ss;
   ss << "(class " << stmt->name.lexeme;
   if (stmt->superclass) {
-    ss << " < " << lox::util::any_to_string(stmt->superclass->accept(this));
+    ss << " < " << lox::util::to_string(stmt->superclass->accept(this));
   }
   ss << " {";
   if (!stmt->methods.empty()) {
     for (const auto& method : stmt->methods) {
       if (method) {
-        ss << lox::util::any_to_string(method->accept(this));
+        ss << lox::util::to_string(method->accept(this));
       }
     }
   }
   ss << "})";
-  return ss.str();
+  return toValue(ss.str());
 }
 
 }  // namespace parser
@@ -1,5 +1,4 @@
 #pragma once
-#include <any>
 #include <string>
 
 #include "Expression.h"
@@ -10,35 +9,35 @@ namespace parser {
 
 class AstPrinter : public ExpressionVisitor, StatementVisitor {
  public:
-  std::string print(const std::shared_ptr<Expression>& expr);
-  std::string print(const std::shared_ptr<Statement>& stmt);
+  std::string print(const Expression* expr);
+  std::string print(const Statement* stmt);
 
-  std::any visit(std::shared_ptr<const Binary> expr) override;
-  std::any visit(std::shared_ptr<const Grouping> expr) override;
-  std::any visit(std::shared_ptr<const Unary> expr) override;
-  std::any visit(std::shared_ptr<const Literal> expr) override;
-  std::any visit(std::shared_ptr<const Variable> expr) override;
-  std::any visit(std::shared_ptr<const Sequence> expr) override;
-  std::any visit(std::shared_ptr<const Ternary> expr) override;
-  std::any visit(std::shared_ptr<const Assignment> expr) override;
-  std::any visit(std::shared_ptr<const Call> expr) override;
-  std::any visit(std::shared_ptr<const Lambda> expr) override;
-  std::any visit(std::shared_ptr<const Get> expr) override;
-  std::any visit(std::shared_ptr<const Set> expr) override;
-  std::any visit(std::shared_ptr<const This> expr) override;
-  std::any visit(std::shared_ptr<const Super> expr) override;
+  lox::lang::Value visit(const Binary* expr) override;
+  lox::lang::Value visit(const Grouping* expr) override;
+  lox::lang::Value visit(const Unary* expr) override;
+  lox::lang::Value visit(const Literal* expr) override;
+  lox::lang::Value visit(const Variable* expr) override;
+  lox::lang::Value visit(const Sequence* expr) override;
+  lox::lang::Value visit(const Ternary* expr) override;
+  lox::lang::Value visit(const Assignment* expr) override;
+  lox::lang::Value visit(const Call* expr) override;
+  lox::lang::Value visit(const Lambda* expr) override;
+  lox::lang::Value visit(const Get* expr) override;
+  lox::lang::Value visit(const Set* expr) override;
+  lox::lang::Value visit(const This* expr) override;
+  lox::lang::Value visit(const Super* expr) override;
 
-  std::any visit(std::shared_ptr<const StatementExpression> stmt) override;
-  std::any visit(std::shared_ptr<const Print> stmt) override;
-  std::any visit(std::shared_ptr<const Var> stmt) override;
-  std::any visit(std::shared_ptr<const Block> stmt) override;
-  std::any visit(std::shared_ptr<const If> stmt) override;
-  std::any visit(std::shared_ptr<const While> stmt) override;
-  std::any visit(std::shared_ptr<const Continue> stmt) override;
-  std::any visit(std::shared_ptr<const Break> stmt) override;
-  std::any visit(std::shared_ptr<const Return> stmt) override;
-  std::any visit(std::shared_ptr<const Function> stmt) override;
-  std::any visit(std::shared_ptr<const Class> stmt) override;
+  lox::lang::Value visit(const StatementExpression* stmt) override;
+  lox::lang::Value visit(const Print* stmt) override;
+  lox::lang::Value visit(const Var* stmt) override;
+  lox::lang::Value visit(const Block* stmt) override;
+  lox::lang::Value visit(const If* stmt) override;
+  lox::lang::Value visit(const While* stmt) override;
+  lox::lang::Value visit(const Continue* stmt) override;
+  lox::lang::Value visit(const Break* stmt) override;
+  lox::lang::Value visit(const Return* stmt) override;
+  lox::lang::Value visit(const Function* stmt) override;
+  lox::lang::Value visit(const Class* stmt) override;
 };
 
 }  // namespace parser
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Value.h"
+
+namespace lox {
+namespace vm {
+
+// Operands are encoded inline after the opcode. Constant, global and jump
+// operands take two bytes (big endian), local, upvalue and argument count
+// operands take one.
+enum class OpCode : uint8_t {
+  CONSTANT,
+  NIL,
+  TRUE,
+  FALSE,
+  POP,
+  GET_LOCAL,
+  SET_LOCAL,
+  GET_GLOBAL,
+  DEFINE_GLOBAL,
+  SET_GLOBAL,
+  GET_UPVALUE,
+  SET_UPVALUE,
+  GET_PROPERTY,
+  SET_PROPERTY,
+  GET_SUPER,
+  EQUAL,
+  GREATER,
+  GREATER_EQUAL,
+  LESS,
+  LESS_EQUAL,
+  ADD,
+  SUBTRACT,
+  MULTIPLY,
+  DIVIDE,
+  NOT,
+  NEGATE,
+  INCREMENT,
+  DECREMENT,
+  TRUTHY,
+  PRINT,
+  JUMP,
+  JUMP_IF_FALSE,
+  LOOP,
+  CALL,
+  INVOKE,
+  SUPER_INVOKE,
+  CLOSURE,
+  CLOSE_UPVALUE,
+  RETURN,
+  CLASS,
+  INHERIT,
+  METHOD,
+};
+
+struct Chunk {
+  std::vector<uint8_t> code;
+  std::vector<int> lines;
+  std::vector<lox::lang::Value> constants;
+
+  void write(uint8_t byte, int line) {
+    code.push_back(byte);
+    lines.push_back(line);
+  }
+
+  void write(OpCode op, int line) { write(static_cast<uint8_t>(op), line); }
+
+  int addConstant(const lox::lang::Value& value) {
+    constants.push_back(value);
+    return constants.size() - 1;
+  }
+};
+
+}  // namespace vm
+}  // namespace lox
@@ -0,0 +1,642 @@
+#include "Compiler.h"
+
+#include "Heap.h"
+#include "LoxString.h"
+#include "lox.h"
+
+using TT = lox::parser::Token::TokenType;
+
+namespace lox {
+namespace vm {
+
+Compiler::Compiler(VM& vm)
+    : vm_(vm),
+      current_(nullptr),
+      loop_(nullptr),
+      class_(nullptr),
+      line_(0),
+      hadError_(false) {}
+
+Function* Compiler::compileScript(const lox::parser::Statement* stmt) {
+  FunctionState script{nullptr, lox::lang::makeObject<Function>("script"),
+                       FunctionType::Script};
+  script.locals.push_back({"", 0, false});
+  current_ = &script;
+  compile(stmt);
+  emitReturn();
+  current_ = nullptr;
+
+  if (hadError_) {
+    return nullptr;
+  }
+  return script.function;
+}
+
+Value Compiler::visit(const lox::parser::Binary* expr) {
+  switch (expr->op.type) {
+    case TT::AND: {
+      compile(expr->left);
+      int endJump = emitJump(OpCode::JUMP_IF_FALSE);
+      emit(OpCode::POP);
+      compile(expr->right);
+      patchJump(endJump);
+      emit(OpCode::TRUTHY);
+      return nullptr;
+    }
+    case TT::OR: {
+      compile(expr->left);
+      int elseJump = emitJump(OpCode::JUMP_IF_FALSE);
+      int endJump = emitJump(OpCode::JUMP);
+      patchJump(elseJump);
+      emit(OpCode::POP);
+      compile(expr->right);
+      patchJump(endJump);
+      emit(OpCode::TRUTHY);
+      return nullptr;
+    }
+    default:
+      break;
+  }
+
+  compile(expr->left);
+  compile(expr->right);
+  line_ = expr->op.line;
+  switch (expr->op.type) {
+    case TT::BANG_EQUAL:
+      emit(OpCode::EQUAL);
+      emit(OpCode::NOT);
+      break;
+    case TT::EQUAL_EQUAL:
+      emit(OpCode::EQUAL);
+      break;
+    case TT::GREATER:
+      emit(OpCode::GREATER);
+      break;
+    case TT::GREATER_EQUAL:
+      emit(OpCode::GREATER_EQUAL);
+      break;
+    case TT::LESS:
+      emit(OpCode::LESS);
+      break;
+    case TT::LESS_EQUAL:
+      emit(OpCode::LESS_EQUAL);
+      break;
+    case TT::PLUS:
+      emit(OpCode::ADD);
+      break;
+    case TT::MINUS:
+      emit(OpCode::SUBTRACT);
+      break;
+    case TT::STAR:
+      emit(OpCode::MULTIPLY);
+      break;
+    case TT::SLASH:
+      emit(OpCode::DIVIDE);
+      break;
+    default:
+      emit(OpCode::POP);
+      emit(OpCode::POP);
+      emit(OpCode::NIL);
+      break;
+  }
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Grouping* expr) {
+  compile(expr->expression);
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Unary* expr) {
+  compile(expr->right);
+  line_ = expr->op.line;
+  switch (expr->op.type) {
+    case TT::MINUS:
+      emit(OpCode::NEGATE);
+      break;
+    case TT::BANG:
+      emit(OpCode::NOT);
+      break;
+    case TT::MINUS_MINUS:
+      emit(OpCode::DECREMENT);
+      break;
+    case TT::PLUS_PLUS:
+      emit(OpCode::INCREMENT);
+      break;
+    default:
+      emit(OpCode::POP);
+      emit(OpCode::NIL);
+      break;
+  }
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Literal* expr) {
+  if (expr->value.isNil()) {
+    emit(OpCode::NIL);
+  } else if (expr->value.isBool()) {
+    emit(expr->value.asBool() ? OpCode::TRUE : OpCode::FALSE);
+  } else {
+    emitConstant(expr->value);
+  }
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Variable* expr) {
+  line_ = expr->token.line;
+  namedVariable(expr->token.lexeme, false);
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Sequence* expr) {
+  for (int i = 0; i < expr->expressions.size(); i++) {
+    compile(expr->expressions[i]);
+    if (i != expr->expressions.size() - 1) {
+      emit(OpCode::POP);
+    }
+  }
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Ternary* expr) {
+  compile(expr->predicate);
+  int elseJump = emitJump(OpCode::JUMP_IF_FALSE);
+  emit(OpCode::POP);
+  compile(expr->then);
+  int endJump = emitJump(OpCode::JUMP);
+  patchJump(elseJump);
+  emit(OpCode::POP);
+  if (expr->alternative) {
+    compile(expr->alternative);
+  } else {
+    emit(OpCode::NIL);
+  }
+  patchJump(endJump);
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Assignment* expr) {
+  compile(expr->target);
+  line_ = expr->token.line;
+  namedVariable(expr->token.lexeme, true);
+  // Assignment is an expression that evaluates to nil.
+  emit(OpCode::POP);
+  emit(OpCode::NIL);
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Call* expr) {
+  int argCount = 0;
+  if (auto get = dynamic_cast<const lox::parser::Get*>(expr->callee)) {
+    compile(get->object);
+    arguments(expr->arguments, &argCount);
+    line_ = expr->paren.line;
+    emitShort(OpCode::INVOKE, identifierConstant(get->name.lexeme));
+    emit(static_cast<uint8_t>(argCount));
+  } else if (auto super =
+                 dynamic_cast<const lox::parser::Super*>(expr->callee)) {
+    line_ = super->keyword.line;
+    namedVariable("this", false);
+    arguments(expr->arguments, &argCount);
+    namedVariable("super", false);
+    line_ = expr->paren.line;
+    emitShort(OpCode::SUPER_INVOKE, identifierConstant(super->method.lexeme));
+    emit(static_cast<uint8_t>(argCount));
+  } else {
+    compile(expr->callee);
+    arguments(expr->arguments, &argCount);
+    line_ = expr->paren.line;
+    emit(OpCode::CALL, argCount);
+  }
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Lambda* expr) {
+  function(expr->function, FunctionType::Function);
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Get* expr) {
+  compile(expr->object);
+  line_ = expr->name.line;
+  emitShort(OpCode::GET_PROPERTY, identifierConstant(expr->name.lexeme));
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Set* expr) {
+  compile(expr->object);
+  compile(expr->value);
+  line_ = expr->name.line;
+  emitShort(OpCode::SET_PROPERTY, identifierConstant(expr->name.lexeme));
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::This* expr) {
+  line_ = expr->token.line;
+  namedVariable("this", false);
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Super* expr) {
+  line_ = expr->keyword.line;
+  namedVariable("this", false);
+  namedVariable("super", false);
+  emitShort(OpCode::GET_SUPER, identifierConstant(expr->method.lexeme));
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::StatementExpression* stmt) {
+  compile(stmt->expression);
+  emit(OpCode::POP);
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Print* stmt) {
+  compile(stmt->expression);
+  emit(OpCode::PRINT);
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Var* stmt) {
+  line_ = stmt->token.line;
+  declareVariable(stmt->token.lexeme);
+  if (stmt->initializer) {
+    compile(stmt->initializer);
+  } else {
+    emit(OpCode::NIL);
+  }
+  defineVariable(stmt->token.lexeme);
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Block* stmt) {
+  beginScope();
+  for (const auto& s : stmt->statements) {
+    if (s) {
+      compile(s);
+    }
+  }
+  endScope();
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::If* stmt) {
+  compile(stmt->predicate);
+  int thenJump = emitJump(OpCode::JUMP_IF_FALSE);
+  emit(OpCode::POP);
+  compile(stmt->then);
+  int elseJump = emitJump(OpCode::JUMP);
+  patchJump(thenJump);
+  emit(OpCode::POP);
+  if (stmt->alternative) {
+    compile(stmt->alternative);
+  }
+  patchJump(elseJump);
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::While* stmt) {
+  LoopState loop{loop_, static_cast<int>(chunk().code.size()),
+                 current_->scopeDepth};
+  int exitJump = -1;
+  if (stmt->condition) {
+    compile(stmt->condition);
+    exitJump = emitJump(OpCode::JUMP_IF_FALSE);
+    emit(OpCode::POP);
+  }
+
+  loop_ = &loop;
+  compile(stmt->body);
+  loop_ = loop.enclosing;
+
+  emitLoop(loop.start);
+  if (stmt->condition) {
+    patchJump(exitJump);
+    emit(OpCode::POP);
+  }
+  for (int jump : loop.breakJumps) {
+    patchJump(jump);
+  }
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Continue* stmt) {
+  line_ = stmt->token.line;
+  if (!loop_) {
+    error("Can't use 'continue' outside of a loop.");
+    return nullptr;
+  }
+  discardLocals(loop_->scopeDepth);
+  emitLoop(loop_->start);
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Break* stmt) {
+  line_ = stmt->token.line;
+  if (!loop_) {
+    error("Can't use 'break' outside of a loop.");
+    return nullptr;
+  }
+  discardLocals(loop_->scopeDepth);
+  loop_->breakJumps.push_back(emitJump(OpCode::JUMP));
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Return* stmt) {
+  line_ = stmt->token.line;
+  if (current_->type == FunctionType::Initializer) {
+    emit(OpCode::GET_LOCAL, 0);
+  } else if (stmt->value) {
+    compile(stmt->value);
+  } else {
+    emit(OpCode::NIL);
+  }
+  emit(OpCode::RETURN);
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Function* stmt) {
+  line_ = stmt->name.line;
+  declareVariable(stmt->name.lexeme);
+  if (current_->scopeDepth > 0) {
+    // Functions may refer to themselves before their definition completes.
+    current_->locals.back().depth = current_->scopeDepth;
+  }
+  function(stmt, FunctionType::Function);
+  defineVariable(stmt->name.lexeme);
+  return nullptr;
+}
+
+Value Compiler::visit(const lox::parser::Class* stmt) {
+  line_ = stmt->name.line;
+  std::string_view name = stmt->name.lexeme;
+  declareVariable(name);
+  emitShort(OpCode::CLASS, identifierConstant(name));
+  defineVariable(name);
+
+  ClassState klass{class_, false};
+  class_ = &klass;
+
+  if (stmt->superclass) {
+    line_ = stmt->superclass->token.line;
+    namedVariable(stmt->superclass->token.lexeme, false);
+    beginScope();
+    addLocal("super");
+    defineVariable("super");
+    namedVariable(name, false);
+    emit(OpCode::INHERIT);
+    klass.hasSuperclass = true;
+  }
+
+  namedVariable(name, false);
+  for (const auto& method : stmt->methods) {
+    bool isInitializer = method->name.lexeme == "init";
+    function(method,
+             isInitializer ? FunctionType::Initializer : FunctionType::Method);
+    emitShort(OpCode::METHOD, identifierConstant(method->name.lexeme));
+  }
+  emit(OpCode::POP);
+
+  if (klass.hasSuperclass) {
+    endScope();
+  }
+  class_ = klass.enclosing;
+  return nullptr;
+}
+
+void Compiler::compile(const lox::parser::Expression* expr) {
+  expr->accept(this);
+}
+
+void Compiler::compile(const lox::parser::Statement* stmt) {
+  stmt->accept(this);
+}
+
+void Compiler::function(const lox::parser::Function* func, FunctionType type) {
+  line_ = func->name.line;
+  FunctionState state{
+      current_,
+      lox::lang::makeObject<Function>(std::string(func->name.lexeme)), type};
+  bool isMethod =
+      type == FunctionType::Method || type == FunctionType::Initializer;
+  state.locals.push_back({isMethod ? "this" : "", 0, false});
+
+  LoopState* enclosingLoop = loop_;
+  loop_ = nullptr;
+  current_ = &state;
+
+  beginScope();
+  for (const auto& param : func->parameters) {
+    if (++state.function->arity > 255) {
+      error("Can't have more than 255 parameters.");
+    }
+    declareVariable(param.lexeme);
+    defineVariable(param.lexeme);
+  }
+  for (const auto& stmt : func->body->statements) {
+    if (stmt) {
+      compile(stmt);
+    }
+  }
+  emitReturn();
+
+  current_ = state.enclosing;
+  loop_ = enclosingLoop;
+
+  state.function->upvalueCount = state.upvalues.size();
+  emitShort(OpCode::CLOSURE, makeConstant(state.function));
+  for (const auto& upvalue : state.upvalues) {
+    emit(upvalue.isLocal ? 1 : 0);
+    emit(upvalue.index);
+  }
+}
+
+void Compiler::arguments(const lox::parser::Expression* args,
+                         int* argCount) {
+  auto seq = dynamic_cast<const lox::parser::Sequence*>(args);
+  if (!seq) {
+    return;
+  }
+  for (const auto& arg : seq->expressions) {
+    compile(arg);
+    if (++(*argCount) > 255) {
+      error("Can't have more than 255 arguments.");
+    }
+  }
+}
+
+void Compiler::emit(uint8_t byte) { chunk().write(byte, line_); }
+
+void Compiler::emit(OpCode op) { chunk().write(op, line_); }
+
+void Compiler::emit(OpCode op, uint8_t operand) {
+  emit(op);
+  emit(operand);
+}
+
+void Compiler::emitShort(OpCode op, int operand) {
+  emit(op);
+  emit(static_cast<uint8_t>((operand >> 8) & 0xff));
+  emit(static_cast<uint8_t>(operand & 0xff));
+}
+
+int Compiler::emitJump(OpCode op) {
+  emitShort(op, 0xffff);
+  return chunk().code.size() - 2;
+}
+
+void Compiler::patchJump(int offset) {
+  int jump = chunk().code.size() - offset - 2;
+  if (jump > 0xffff) {
+    error("Too much code to jump over.");
+  }
+  chunk().code[offset] = (jump >> 8) & 0xff;
+  chunk().code[offset + 1] = jump & 0xff;
+}
+
+void Compiler::emitLoop(int start) {
+  int offset = chunk().code.size() - start + 3;
+  if (offset > 0xffff) {
+    error("Loop body too large.");
+  }
+  emitShort(OpCode::LOOP, offset);
+}
+
+void Compiler::emitReturn() {
+  if (current_->type == FunctionType::Initializer) {
+    emit(OpCode::GET_LOCAL, 0);
+  } else {
+    emit(OpCode::NIL);
+  }
+  emit(OpCode::RETURN);
+}
+
+void Compiler::emitConstant(const Value& value) {
+  emitShort(OpCode::CONSTANT, makeConstant(value));
+}
+
+int Compiler::makeConstant(const Value& value) {
+  int constant = chunk().addConstant(value);
+  if (constant > 0xffff) {
+    error("Too many constants in one chunk.");
+    return 0;
+  }
+  return constant;
+}
+
+int Compiler::identifierConstant(std::string_view name) {
+  auto it = current_->identifiers.find(name);
+  if (it != current_->identifiers.end()) {
+    return it->second;
+  }
+  int constant = makeConstant(lox::lang::strings().intern(name));
+  current_->identifiers.insert({name, constant});
+  return constant;
+}
+
+void Compiler::beginScope() { current_->scopeDepth++; }
+
+void Compiler::endScope() {
+  current_->scopeDepth--;
+  auto& locals = current_->locals;
+  while (!locals.empty() && locals.back().depth > current_->scopeDepth) {
+    emit(locals.back().isCaptured ? OpCode::CLOSE_UPVALUE : OpCode::POP);
+    locals.pop_back();
+  }
+}
+
+void Compiler::discardLocals(int depth) {
+  const auto& locals = current_->locals;
+  for (int i = locals.size() - 1; i >= 0 && locals[i].depth > depth; i--) {
+    emit(locals[i].isCaptured ? OpCode::CLOSE_UPVALUE : OpCode::POP);
+  }
+}
+
+void Compiler::declareVariable(std::string_view name) {
+  if (current_->scopeDepth == 0) {
+    return;
+  }
+  addLocal(name);
+}
+
+void Compiler::defineVariable(std::string_view name) {
+  if (current_->scopeDepth > 0) {
+    current_->locals.back().depth = current_->scopeDepth;
+    return;
+  }
+  emitShort(OpCode::DEFINE_GLOBAL, vm_.globalSlot(std::string(name)));
+}
+
+void Compiler::addLocal(std::string_view name) {
+  if (current_->locals.size() == 256) {
+    error("Too many local variables in function.");
+    return;
+  }
+  current_->locals.push_back({name, -1, false});
+}
+
+void Compiler::namedVariable(std::string_view name, bool assign) {
+  int arg = resolveLocal(current_, name);
+  if (arg != -1) {
+    emit(assign ? OpCode::SET_LOCAL : OpCode::GET_LOCAL, arg);
+    return;
+  }
+  arg = resolveUpvalue(current_, name);
+  if (arg != -1) {
+    emit(assign ? OpCode::SET_UPVALUE : OpCode::GET_UPVALUE, arg);
+    return;
+  }
+  int slot = vm_.globalSlot(std::string(name));
+  if (slot > 0xffff) {
+    error("Too many global variables.");
+  }
+  emitShort(assign ? OpCode::SET_GLOBAL : OpCode::GET_GLOBAL, slot);
+}
+
+int Compiler::resolveLocal(FunctionState* state, std::string_view name) {
+  for (int i = state->locals.size() - 1; i >= 0; i--) {
+    if (state->locals[i].name == name) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int Compiler::resolveUpvalue(FunctionState* state, std::string_view name) {
+  if (!state->enclosing) {
+    return -1;
+  }
+  int local = resolveLocal(state->enclosing, name);
+  if (local != -1) {
+    state->enclosing->locals[local].isCaptured = true;
+    return addUpvalue(state, local, true);
+  }
+  int upvalue = resolveUpvalue(state->enclosing, name);
+  if (upvalue != -1) {
+    return addUpvalue(state, upvalue, false);
+  }
+  return -1;
+}
+
+int Compiler::addUpvalue(FunctionState* state, uint8_t index, bool isLocal) {
+  auto& upvalues = state->upvalues;
+  for (int i = 0; i < upvalues.size(); i++) {
+    if (upvalues[i].index == index && upvalues[i].isLocal == isLocal) {
+      return i;
+    }
+  }
+  if (upvalues.size() == 256) {
+    error("Too many closure variables in function.");
+    return 0;
+  }
+  upvalues.push_back({index, isLocal});
+  return upvalues.size() - 1;
+}
+
+void Compiler::error(const std::string& message) {
+  lox::lang::Lox::error(line_, message);
+  hadError_ = true;
+}
+
+}  // namespace vm
+}  // namespace lox
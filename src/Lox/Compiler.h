@@ -0,0 +1,135 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Chunk.h"
+#include "Expression.h"
+#include "Statement.h"
+#include "VM.h"
+#include "VmObjects.h"
+
+namespace lox {
+namespace vm {
+
+// Lowers a resolved statement into bytecode. Local variables are assigned
+// stack slots at compile time and variables captured by closures become
+// upvalues, so the VM never looks up locals by name.
+class Compiler : public lox::parser::ExpressionVisitor,
+                 lox::parser::StatementVisitor {
+ public:
+  explicit Compiler(VM& vm);
+
+  // Compiles one top level statement into a script function, returns nullptr
+  // if compilation failed.
+  Function* compileScript(const lox::parser::Statement* stmt);
+
+  Value visit(const lox::parser::Binary* expr) override;
+  Value visit(const lox::parser::Grouping* expr) override;
+  Value visit(const lox::parser::Unary* expr) override;
+  Value visit(const lox::parser::Literal* expr) override;
+  Value visit(const lox::parser::Variable* expr) override;
+  Value visit(const lox::parser::Sequence* expr) override;
+  Value visit(const lox::parser::Ternary* expr) override;
+  Value visit(const lox::parser::Assignment* expr) override;
+  Value visit(const lox::parser::Call* expr) override;
+  Value visit(const lox::parser::Lambda* expr) override;
+  Value visit(const lox::parser::Get* expr) override;
+  Value visit(const lox::parser::Set* expr) override;
+  Value visit(const lox::parser::This* expr) override;
+  Value visit(const lox::parser::Super* expr) override;
+
+  Value visit(const lox::parser::StatementExpression* stmt) override;
+  Value visit(const lox::parser::Print* stmt) override;
+  Value visit(const lox::parser::Var* stmt) override;
+  Value visit(const lox::parser::Block* stmt) override;
+  Value visit(const lox::parser::If* stmt) override;
+  Value visit(const lox::parser::While* stmt) override;
+  Value visit(const lox::parser::Continue* stmt) override;
+  Value visit(const lox::parser::Break* stmt) override;
+  Value visit(const lox::parser::Return* stmt) override;
+  Value visit(const lox::parser::Function* stmt) override;
+  Value visit(const lox::parser::Class* stmt) override;
+
+ private:
+  enum class FunctionType { Script, Function, Method, Initializer };
+
+  struct Local {
+    std::string_view name;
+    int depth;
+    bool isCaptured;
+  };
+
+  struct UpvalueRef {
+    uint8_t index;
+    bool isLocal;
+  };
+
+  struct FunctionState {
+    FunctionState* enclosing;
+    Function* function;
+    FunctionType type;
+    std::vector<Local> locals;
+    std::vector<UpvalueRef> upvalues;
+    int scopeDepth;
+    std::unordered_map<std::string_view, int> identifiers;
+  };
+
+  struct LoopState {
+    LoopState* enclosing;
+    int start;
+    int scopeDepth;
+    std::vector<int> breakJumps;
+  };
+
+  struct ClassState {
+    ClassState* enclosing;
+    bool hasSuperclass;
+  };
+
+  VM& vm_;
+  FunctionState* current_;
+  LoopState* loop_;
+  ClassState* class_;
+  int line_;
+  bool hadError_;
+
+  Chunk& chunk() { return current_->function->chunk; }
+
+  void compile(const lox::parser::Expression* expr);
+  void compile(const lox::parser::Statement* stmt);
+  void function(const lox::parser::Function* func,
+                FunctionType type);
+  void arguments(const lox::parser::Expression* args,
+                 int* argCount);
+
+  void emit(uint8_t byte);
+  void emit(OpCode op);
+  void emit(OpCode op, uint8_t operand);
+  void emitShort(OpCode op, int operand);
+  int emitJump(OpCode op);
+  void patchJump(int offset);
+  void emitLoop(int start);
+  void emitReturn();
+  void emitConstant(const Value& value);
+  int makeConstant(const Value& value);
+  int identifierConstant(std::string_view name);
+
+  void beginScope();
+  void endScope();
+  void discardLocals(int depth);
+  void declareVariable(std::string_view name);
+  void defineVariable(std::string_view name);
+  void addLocal(std::string_view name);
+  void namedVariable(std::string_view name, bool assign);
+  int resolveLocal(FunctionState* state, std::string_view name);
+  int resolveUpvalue(FunctionState* state, std::string_view name);
+  int addUpvalue(FunctionState* state, uint8_t index, bool isLocal);
+
+  void error(const std::string& message);
+};
+
+}  // namespace vm
+}  // namespace lox
@@ -0,0 +1,94 @@
+#include "Heap.h"
+
+#include <algorithm>
+
+namespace lox {
+namespace lang {
+
+Heap::Heap()
+    : objects_(nullptr),
+      bytes_(0),
+      threshold_(kMinThreshold),
+      growthFactor_(kDefaultGrowthFactor),
+      profile_(nullptr) {}
+
+Heap::~Heap() {
+  while (objects_) {
+    LoxObject* next = objects_->next_;
+    delete objects_;
+    objects_ = next;
+  }
+}
+
+void Heap::collect() {
+  auto start = std::chrono::steady_clock::now();
+
+  for (auto source : sources_) {
+    source->markRoots(*this);
+  }
+  for (const auto& [object, count] : pinned_) {
+    mark(object);
+  }
+  for (const auto& value : temps_) {
+    mark(value);
+  }
+  while (!gray_.empty()) {
+    LoxObject* object = gray_.back();
+    gray_.pop_back();
+    object->trace(*this);
+  }
+  sweep();
+
+  threshold_ = std::max(static_cast<size_t>(bytes_ * growthFactor_),
+                        kMinThreshold);
+  stats_.collections++;
+  stats_.pauseTime += std::chrono::steady_clock::now() - start;
+  if (profile_) {
+    profile_->collected(*this);
+  }
+}
+
+void Heap::sweep() {
+  LoxObject** link = &objects_;
+  while (LoxObject* object = *link) {
+    if (object->marked_) {
+      object->marked_ = false;
+      link = &object->next_;
+      continue;
+    }
+    *link = object->next_;
+    bytes_ -= object->size_;
+    stats_.bytesFreed += object->size_;
+    stats_.objectsFreed++;
+    if (profile_) {
+      profile_->freed(object);
+    }
+    delete object;
+  }
+}
+
+void Heap::addRoots(RootSource* source) { sources_.push_back(source); }
+
+void Heap::removeRoots(RootSource* source) {
+  sources_.erase(std::remove(sources_.begin(), sources_.end(), source),
+                 sources_.end());
+}
+
+void Heap::pin(const Value& value) {
+  if (value.isObject()) {
+    pinned_[value.asObject()]++;
+  }
+}
+
+void Heap::unpin(const Value& value) {
+  if (!value.isObject()) {
+    return;
+  }
+  auto it = pinned_.find(value.asObject());
+  if (it != pinned_.end() && --it->second == 0) {
+    pinned_.erase(it);
+  }
+}
+
+}  // namespace lang
+}  // namespace lox
@@ -0,0 +1,173 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "HeapProfile.h"
+#include "LoxObject.h"
+#include "Value.h"
+
+namespace lox {
+namespace lang {
+
+// Counters over the lifetime of a Heap.
+struct HeapStats {
+  size_t collections = 0;
+  size_t objectsAllocated = 0;
+  size_t objectsFreed = 0;
+  size_t bytesAllocated = 0;
+  size_t bytesFreed = 0;
+  size_t peakBytes = 0;
+  std::chrono::nanoseconds pauseTime{0};
+};
+
+// Something outside the heap holding references into it, the interpreter or
+// the VM. Every registered source marks its roots at each collection.
+class RootSource {
+ public:
+  virtual ~RootSource() = default;
+  virtual void markRoots(Heap& heap) = 0;
+};
+
+// Mark-sweep garbage collector owning every LoxObject.
+//
+// Allocating only accounts for the new object, collections run at safepoints:
+// places where the interpreter and the VM keep everything they still use
+// reachable from their roots, i.e. statement boundaries, loop back edges and
+// calls. C++ code holding values across a safepoint pushes them to TempRoots.
+class Heap {
+ public:
+  static constexpr size_t kMinThreshold = 1024 * 1024;
+  static constexpr double kDefaultGrowthFactor = 2.0;
+
+  Heap();
+  Heap(const Heap&) = delete;
+  Heap& operator=(const Heap&) = delete;
+  ~Heap();
+
+  template <typename T, typename... Args>
+  T* allocate(Args&&... args) {
+    T* object = new T(std::forward<Args>(args)...);
+    size_t size = sizeof(T) + object->extraBytes();
+    object->size_ = size;
+    object->next_ = objects_;
+    objects_ = object;
+    bytes_ += size;
+    stats_.objectsAllocated++;
+    stats_.bytesAllocated += size;
+    if (bytes_ > stats_.peakBytes) {
+      stats_.peakBytes = bytes_;
+    }
+    if (profile_) {
+      profile_->allocated(object, size);
+    }
+    return object;
+  }
+
+  // Accounts for `bytes` more memory `object` took since it was allocated.
+  void grow(LoxObject* object, size_t bytes) {
+    object->size_ += bytes;
+    bytes_ += bytes;
+    stats_.bytesAllocated += bytes;
+    if (bytes_ > stats_.peakBytes) {
+      stats_.peakBytes = bytes_;
+    }
+  }
+
+  // Collects if the heap outgrew its threshold since the last collection.
+  void safepoint() {
+    if (bytes_ > threshold_) {
+      collect();
+    }
+  }
+  void collect();
+
+  void mark(const Value& value) {
+    if (value.isObject()) {
+      mark(value.asObject());
+    }
+  }
+  void mark(LoxObject* object) {
+    if (object && !object->marked_) {
+      object->marked_ = true;
+      gray_.push_back(object);
+    }
+  }
+
+  void addRoots(RootSource* source);
+  void removeRoots(RootSource* source);
+
+  // Keeps the object of `value` alive until the matching unpin(), for
+  // references living longer than a safepoint outside of any root source,
+  // e.g. string literals in the syntax tree.
+  void pin(const Value& value);
+  void unpin(const Value& value);
+
+  // After a collection the next one is due once the heap grew by this factor.
+  void setGrowthFactor(double factor) { growthFactor_ = factor; }
+  double growthFactor() const { return growthFactor_; }
+
+  size_t bytesInUse() const { return bytes_; }
+  size_t liveObjects() const {
+    return stats_.objectsAllocated - stats_.objectsFreed;
+  }
+  const HeapStats& stats() const { return stats_; }
+
+  // Reports allocations and frees to `profile`, nullptr stops.
+  void setProfile(HeapProfile* profile) { profile_ = profile; }
+  HeapProfile* profile() const { return profile_; }
+
+ private:
+  friend class TempRoots;
+
+  LoxObject* objects_;
+  size_t bytes_;
+  size_t threshold_;
+  double growthFactor_;
+  HeapStats stats_;
+  HeapProfile* profile_;
+
+  std::vector<RootSource*> sources_;
+  std::unordered_map<LoxObject*, uint32_t> pinned_;
+  std::vector<Value> temps_;
+  std::vector<LoxObject*> gray_;
+
+  void sweep();
+};
+
+// Heap shared by every interpreter and VM. Never destroyed, objects may still
+// be referenced during static destruction.
+inline Heap& heap() {
+  static auto* heap = new Heap();
+  return *heap;
+}
+
+template <typename T, typename... Args>
+T* makeObject(Args&&... args) {
+  return heap().allocate<T>(std::forward<Args>(args)...);
+}
+
+// Roots values held in C++ locals across safepoints for the lifetime of the
+// guard. Guards nest like the scopes declaring them.
+class TempRoots {
+ public:
+  TempRoots() : size_(heap().temps_.size()) {}
+  TempRoots(const TempRoots&) = delete;
+  TempRoots& operator=(const TempRoots&) = delete;
+  ~TempRoots() { heap().temps_.resize(size_); }
+
+  void push(const Value& value) {
+    if (value.isObject()) {
+      heap().temps_.push_back(value);
+    }
+  }
+
+ private:
+  const size_t size_;
+};
+
+}  // namespace lang
+}  // namespace lox
@@ -0,0 +1,124 @@
+#include "HeapProfile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <tuple>
+#include <vector>
+
+#include "Heap.h"
+#include "LoxObject.h"
+
+namespace lox {
+namespace lang {
+
+namespace {
+
+std::string kindOf(const LoxObject* object) {
+  switch (object->type()) {
+    case ObjectType::String:
+      return "String";
+    case ObjectType::Function:
+    case ObjectType::VmFunction:
+      return "Function";
+    case ObjectType::Native:
+    case ObjectType::VmNative:
+      return "Native";
+    case ObjectType::Class:
+    case ObjectType::VmClass:
+      return "Class";
+    case ObjectType::Instance:
+    case ObjectType::VmInstance:
+      // "Instance of Class <name>", one entry per class.
+      return object->toString();
+    case ObjectType::Cell:
+      return "Cell";
+    case ObjectType::VmClosure:
+      return "Closure";
+    case ObjectType::VmUpvalue:
+      return "Upvalue";
+    case ObjectType::VmBoundMethod:
+      return "BoundMethod";
+  }
+  return "Object";
+}
+
+template <typename Key>
+void writeTable(std::ostream& out, const char* title,
+                const std::unordered_map<Key, HeapProfile::Counters>& table,
+                std::string (*name)(const Key&)) {
+  std::vector<std::pair<Key, HeapProfile::Counters>> rows(table.begin(),
+                                                          table.end());
+  std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+    return std::tie(b.second.liveBytes, b.second.bytes, a.first) <
+           std::tie(a.second.liveBytes, a.second.bytes, b.first);
+  });
+  char row[160];
+  std::snprintf(row, sizeof(row), "%12s %12s %12s %12s  %s\n", "live bytes",
+                "live objects", "bytes", "objects", title);
+  out << row;
+  for (const auto& [key, counters] : rows) {
+    std::snprintf(row, sizeof(row), "%12llu %12llu %12llu %12llu  %s\n",
+                  static_cast<unsigned long long>(counters.liveBytes),
+                  static_cast<unsigned long long>(counters.liveObjects),
+                  static_cast<unsigned long long>(counters.bytes),
+                  static_cast<unsigned long long>(counters.objects),
+                  name(key).c_str());
+    out << row;
+  }
+}
+
+}  // namespace
+
+HeapProfile::HeapProfile(std::ostream& out, int interval)
+    : out_(out),
+      interval_(std::max(interval, 1)),
+      line_(0),
+      collections_(0),
+      snapshots_(0) {}
+
+void HeapProfile::allocated(const LoxObject* object, size_t size) {
+  auto& kind = kinds_[kindOf(object)];
+  auto& line = lines_[line_];
+  for (auto* counters : {&kind, &line}) {
+    counters->objects++;
+    counters->bytes += size;
+    counters->liveObjects++;
+    counters->liveBytes += size;
+  }
+  live_[object] = Owner{&kind, &line, size};
+}
+
+void HeapProfile::freed(const LoxObject* object) {
+  auto it = live_.find(object);
+  // Allocated before profiling started.
+  if (it == live_.end()) {
+    return;
+  }
+  for (auto* counters : {it->second.kind, it->second.line}) {
+    counters->liveObjects--;
+    counters->liveBytes -= it->second.size;
+  }
+  live_.erase(it);
+}
+
+void HeapProfile::collected(const Heap& heap) {
+  if (++collections_ % interval_ == 0) {
+    snapshot(heap, "collection " + std::to_string(heap.stats().collections));
+  }
+}
+
+void HeapProfile::snapshot(const Heap& heap, const std::string& title) {
+  out_ << "snapshot " << ++snapshots_ << ", " << title << ": "
+       << heap.liveObjects() << " objects, " << heap.bytesInUse()
+       << " bytes in use\n";
+  writeTable<std::string>(out_, "kind", kinds_,
+                          [](const std::string& kind) { return kind; });
+  writeTable<int>(out_, "line", lines_, [](const int& line) {
+    return line ? std::to_string(line) : std::string("-");
+  });
+  out_ << "\n";
+  out_.flush();
+}
+
+}  // namespace lang
+}  // namespace lox
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+namespace lox {
+namespace lang {
+
+class Heap;
+class LoxObject;
+
+// Allocation counters of the Heap, per kind of object and per source line.
+//
+// Every allocation counts towards its kind, instances towards their class,
+// and towards the line of the statement the tree walker was executing.
+// Objects the collector frees are subtracted from the live counters again,
+// so what remains live after a collection is retained. Snapshots of both
+// tables are written after every `interval` collections and by snapshot().
+// Allocations of the VM and outside of any statement count on line 0.
+class HeapProfile {
+ public:
+  struct Counters {
+    uint64_t objects = 0;
+    uint64_t bytes = 0;
+    uint64_t liveObjects = 0;
+    uint64_t liveBytes = 0;
+  };
+
+  // Sets the line allocations count towards for the lifetime of the scope,
+  // does nothing without a profile.
+  class Site {
+   public:
+    Site(HeapProfile* profile, int line)
+        : profile_(profile), previous_(profile ? profile->line_ : 0) {
+      if (profile_) {
+        profile_->line_ = line;
+      }
+    }
+    Site(const Site&) = delete;
+    Site& operator=(const Site&) = delete;
+    ~Site() {
+      if (profile_) {
+        profile_->line_ = previous_;
+      }
+    }
+
+   private:
+    HeapProfile* const profile_;
+    const int previous_;
+  };
+
+  explicit HeapProfile(std::ostream& out, int interval = 1);
+  HeapProfile(const HeapProfile&) = delete;
+  HeapProfile& operator=(const HeapProfile&) = delete;
+
+  void allocated(const LoxObject* object, size_t size);
+  void freed(const LoxObject* object);
+  // Called by the heap after every collection.
+  void collected(const Heap& heap);
+  // Writes the counters of every kind and line with live or allocated
+  // objects, the most live bytes first.
+  void snapshot(const Heap& heap, const std::string& title);
+
+  const std::unordered_map<std::string, Counters>& kinds() const {
+    return kinds_;
+  }
+  const std::unordered_map<int, Counters>& lines() const { return lines_; }
+  int snapshots() const { return snapshots_; }
+
+ private:
+  struct Owner {
+    Counters* kind;
+    Counters* line;
+    size_t size;
+  };
+
+  std::ostream& out_;
+  const int interval_;
+  int line_;
+  int collections_;
+  int snapshots_;
+  std::unordered_map<std::string, Counters> kinds_;
+  std::unordered_map<int, Counters> lines_;
+  std::unordered_map<const LoxObject*, Owner> live_;
+};
+
+}  // namespace lang
+}  // namespace lox
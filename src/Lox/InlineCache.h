@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace lox {
+namespace lang {
+
+class LoxFunction;
+class Shape;
+
+// Hit and miss counts of a family of inline caches.
+struct CacheCounters {
+  size_t hits = 0;
+  size_t misses = 0;
+
+  double hitRate() const {
+    size_t total = hits + misses;
+    return total ? static_cast<double>(hits) / total : 0;
+  }
+};
+
+// Counters of every inline cache in the process, by the kind of site.
+struct InlineCacheStats {
+  CacheCounters get;
+  CacheCounters set;
+  CacheCounters invoke;
+};
+
+inline InlineCacheStats& inlineCacheStats() {
+  static InlineCacheStats stats;
+  return stats;
+}
+
+// Polymorphic inline cache of a property access site. It remembers how the
+// property resolved for the last few receiver shapes, so a site that keeps
+// seeing the same layouts loads fields by slot and finds methods without
+// hashing the name.
+//
+// An entry is one of:
+//   field      - the receiver shape has the field in `slot`
+//   method     - the receiver class `classId` resolves the name to `method`
+//                and the shape has no field shadowing it
+//   transition - storing the missing field moves the receiver to `next`
+//                and appends the value at `slot`
+// Shapes are never freed, so their addresses identify a layout for good.
+// Classes are identified by id instead, addresses get reused after a
+// collection. A method cached for a live class id is alive as well.
+class PropertyCache {
+ public:
+  static constexpr int kEntries = 4;
+
+  struct Entry {
+    const Shape* shape = nullptr;
+    uint64_t classId = 0;
+    int slot = -1;
+    LoxFunction* method = nullptr;
+    Shape* next = nullptr;
+  };
+
+  explicit PropertyCache(CacheCounters& counters) : counters_(counters) {}
+
+  const Entry* find(const Shape* shape, uint64_t classId) const {
+    for (int i = 0; i < size_; i++) {
+      const Entry& entry = entries_[i];
+      if (entry.shape == shape &&
+          (entry.method == nullptr || entry.classId == classId)) {
+        counters_.hits++;
+        return &entry;
+      }
+    }
+    counters_.misses++;
+    return nullptr;
+  }
+
+  // Sites seeing more layouts than kEntries stay on the slow path for the
+  // layouts that did not fit.
+  void add(const Entry& entry) {
+    if (size_ < kEntries) {
+      entries_[size_++] = entry;
+    }
+  }
+
+  int size() const { return size_; }
+
+ private:
+  CacheCounters& counters_;
+  Entry entries_[kEntries];
+  int size_ = 0;
+};
+
+}  // namespace lang
+}  // namespace lox
@@ -0,0 +1,734 @@
+#include "Jit.h"
+
+#include "Environment.h"
+#include "LoxFunction.h"
+#include "Statement.h"
+
+#if defined(__x86_64__) && defined(__linux__)
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <initializer_list>
+
+namespace lox {
+namespace lang {
+
+namespace {
+
+using TT = lox::parser::Token::TokenType;
+
+// Condition codes of the jcc instructions, after ucomisd: below and above
+// are the unsigned comparisons, parity is set for unordered operands, NaN.
+enum Condition : uint8_t {
+  kBelow = 0x2,
+  kAboveEqual = 0x3,
+  kEqual = 0x4,
+  kNotEqual = 0x5,
+  kBelowEqual = 0x6,
+  kAbove = 0x7,
+  kParity = 0xA,
+  kLess = 0xC,
+};
+
+Condition negate(Condition condition) {
+  return static_cast<Condition>(condition ^ 1);
+}
+
+// Emits the handful of x86-64 instructions the compiler needs. Jumps and
+// calls to labels take a rel32 operand, patched by finish() once every
+// label is bound.
+//
+// Registers: rbp is the frame pointer, rbx holds the JitContext, r12 the
+// result pointer, xmm0 the value of the expression being evaluated and
+// xmm1 and xmm2 are scratch.
+class Assembler {
+ public:
+  using Label = size_t;
+
+  Label newLabel() {
+    labels_.push_back(kUnbound);
+    return labels_.size() - 1;
+  }
+  void bind(Label label) { labels_[label] = code_.size(); }
+
+  void emit(std::initializer_list<uint8_t> bytes) {
+    code_.insert(code_.end(), bytes);
+  }
+  void emit32(uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+      code_.push_back(value >> (8 * i));
+    }
+  }
+  void emit64(uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+      code_.push_back(value >> (8 * i));
+    }
+  }
+
+  void jump(Label label) {
+    emit({0xE9});
+    fixup(label);
+  }
+  void jump(Condition condition, Label label) {
+    emit({0x0F, static_cast<uint8_t>(0x80 | condition)});
+    fixup(label);
+  }
+  void call(Label label) {
+    emit({0xE8});
+    fixup(label);
+  }
+  // mov rax, address; call rax
+  void call(const void* address) {
+    emit({0x48, 0xB8});
+    emit64(reinterpret_cast<uintptr_t>(address));
+    emit({0xFF, 0xD0});
+  }
+
+  // movsd xmm, [rbp + disp]
+  void load(int xmm, int32_t disp) {
+    emit({0xF2, 0x0F, 0x10, static_cast<uint8_t>(0x85 | xmm << 3)});
+    emit32(disp);
+  }
+  // movsd [rbp + disp], xmm0
+  void store(int32_t disp) {
+    emit({0xF2, 0x0F, 0x11, 0x85});
+    emit32(disp);
+  }
+  // mov rax, bits; movq xmm, rax
+  void constant(int xmm, double number) {
+    uint64_t bits;
+    std::memcpy(&bits, &number, sizeof(bits));
+    emit({0x48, 0xB8});
+    emit64(bits);
+    emit({0x66, 0x48, 0x0F, 0x6E, static_cast<uint8_t>(0xC0 | xmm << 3)});
+  }
+  // sub rsp, 8; movsd [rsp], xmm0
+  void push() { emit({0x48, 0x83, 0xEC, 0x08, 0xF2, 0x0F, 0x11, 0x04, 0x24}); }
+  // movsd xmm, [rsp]; add rsp, 8
+  void pop(int xmm) {
+    emit({0xF2, 0x0F, 0x10, static_cast<uint8_t>(0x04 | xmm << 3), 0x24});
+    emit({0x48, 0x83, 0xC4, 0x08});
+  }
+
+  // Register to register SSE2 instructions, `op xmm, other`.
+  void sse(std::initializer_list<uint8_t> opcode, int xmm, int other) {
+    emit(opcode);
+    emit({static_cast<uint8_t>(0xC0 | xmm << 3 | other)});
+  }
+  void addsd(int xmm, int other) { sse({0xF2, 0x0F, 0x58}, xmm, other); }
+  void subsd(int xmm, int other) { sse({0xF2, 0x0F, 0x5C}, xmm, other); }
+  void mulsd(int xmm, int other) { sse({0xF2, 0x0F, 0x59}, xmm, other); }
+  void divsd(int xmm, int other) { sse({0xF2, 0x0F, 0x5E}, xmm, other); }
+  void movapd(int xmm, int other) { sse({0x66, 0x0F, 0x28}, xmm, other); }
+  void xorpd(int xmm, int other) { sse({0x66, 0x0F, 0x57}, xmm, other); }
+  void ucomisd(int xmm, int other) { sse({0x66, 0x0F, 0x2E}, xmm, other); }
+
+  // Patches the jumps and calls to labels and returns the code.
+  std::vector<uint8_t> finish() {
+    for (const auto& fixup : fixups_) {
+      int32_t offset = labels_[fixup.label] - (fixup.position + 4);
+      std::memcpy(&code_[fixup.position], &offset, sizeof(offset));
+    }
+    return std::move(code_);
+  }
+
+ private:
+  static constexpr size_t kUnbound = SIZE_MAX;
+
+  struct Fixup {
+    size_t position;
+    Label label;
+  };
+
+  std::vector<uint8_t> code_;
+  std::vector<size_t> labels_;
+  std::vector<Fixup> fixups_;
+
+  void fixup(Label label) {
+    fixups_.push_back({code_.size(), label});
+    emit32(0);
+  }
+};
+
+// Skips the nodes that only matter to the parser, parentheses and
+// sequences of a single expression.
+const lox::parser::Expression* unwrap(const lox::parser::Expression* expr) {
+  while (true) {
+    if (auto grouping = dynamic_cast<const lox::parser::Grouping*>(expr)) {
+      expr = grouping->expression;
+    } else if (auto sequence =
+                   dynamic_cast<const lox::parser::Sequence*>(expr);
+               sequence && sequence->expressions.size() == 1) {
+      expr = sequence->expressions[0];
+    } else {
+      return expr;
+    }
+  }
+}
+
+}  // namespace
+
+// Compiles one function. Values are numbers throughout: expressions leave
+// their value in xmm0 and spill the left operand of binary operators to the
+// native stack, conditions compile to jumps. Whatever does not fit throws
+// Unsupported.
+class FunctionCompiler {
+ public:
+  FunctionCompiler(Jit& jit, const lox::parser::Function* declaration,
+                   const Globals& globals)
+      : jit_(jit), declaration_(declaration), globals_(globals) {}
+
+  // Returns false if the function uses anything the JIT does not support.
+  bool compile(std::vector<uint8_t>& code);
+  const std::vector<Value>& callees() const { return callees_; }
+
+ private:
+  using Label = Assembler::Label;
+
+  struct Unsupported {};
+
+  struct Loop {
+    Label start;
+    Label end;
+  };
+
+  Jit& jit_;
+  const lox::parser::Function* const declaration_;
+  const Globals& globals_;
+  Assembler assembler_;
+  Label entry_;
+  Label return_;
+  Label bailout_;
+  std::vector<Loop> loops_;
+  std::vector<Value> callees_;
+
+  void statements(lox::parser::Span<lox::parser::Statement*> statements);
+  void statement(const lox::parser::Statement* stmt);
+  // Evaluates an expression statement for its effect.
+  void effect(const lox::parser::Expression* expr);
+  // Evaluates a number to xmm0.
+  void number(const lox::parser::Expression* expr);
+  // Evaluates the operands of `expr` to xmm0 and xmm1.
+  void operands(const lox::parser::Binary* expr);
+  // Jumps to `label` if the truthiness of `expr` is `jumpIf`.
+  void branch(const lox::parser::Expression* expr, bool jumpIf, Label label);
+  // Jumps to `label` if the operands of the last ucomisd are equal, or not
+  // `equal`. NaN is equal to nothing.
+  void branchEqual(bool equal, Label label);
+  void call(const lox::parser::Call* expr);
+  // Frame offset of a local variable.
+  int32_t local(const lox::parser::Binding& binding) const;
+
+  static int32_t slot(int index) { return -24 - 8 * index; }
+};
+
+bool FunctionCompiler::compile(std::vector<uint8_t>& code) {
+  if (!declaration_->captures.empty() ||
+      !declaration_->boxedParameters.empty()) {
+    return false;
+  }
+
+  auto& a = assembler_;
+  entry_ = a.newLabel();
+  return_ = a.newLabel();
+  bailout_ = a.newLabel();
+
+  a.bind(entry_);
+  // push rbp; mov rbp, rsp; push rbx; push r12; mov rbx, rdx; mov r12, rsi
+  a.emit({0x55, 0x48, 0x89, 0xE5, 0x53, 0x41, 0x54});
+  a.emit({0x48, 0x89, 0xD3, 0x49, 0x89, 0xF4});
+  // sub rsp, frame size
+  a.emit({0x48, 0x81, 0xEC});
+  a.emit32((8 * declaration_->slots + 15) & ~15);
+  // sub qword [rbx + 8], 1; jl bailout
+  a.emit({0x48, 0x83, 0x6B, 0x08, 0x01});
+  a.jump(kLess, bailout_);
+  // The arguments go to the parameter slots, after the callee's.
+  for (size_t i = 0; i < declaration_->parameters.size(); i++) {
+    // movsd xmm0, [rdi + 8 * i]
+    a.emit({0xF2, 0x0F, 0x10, 0x87});
+    a.emit32(8 * i);
+    a.store(slot(i + 1));
+  }
+
+  try {
+    statements(declaration_->body->statements);
+  } catch (const Unsupported&) {
+    return false;
+  }
+  // Falling off the end returns nil, which is not a number.
+  a.jump(bailout_);
+
+  a.bind(return_);
+  // add qword [rbx + 8], 1; mov eax, 1
+  a.emit({0x48, 0x83, 0x43, 0x08, 0x01, 0xB8, 0x01, 0x00, 0x00, 0x00});
+  // lea rsp, [rbp - 16]; pop r12; pop rbx; pop rbp; ret
+  a.emit({0x48, 0x8D, 0x65, 0xF0, 0x41, 0x5C, 0x5B, 0x5D, 0xC3});
+
+  a.bind(bailout_);
+  // xor eax, eax
+  a.emit({0x31, 0xC0});
+  a.emit({0x48, 0x8D, 0x65, 0xF0, 0x41, 0x5C, 0x5B, 0x5D, 0xC3});
+
+  code = a.finish();
+  return true;
+}
+
+void FunctionCompiler::statements(
+    lox::parser::Span<lox::parser::Statement*> statements) {
+  for (auto stmt : statements) {
+    if (stmt) {
+      statement(stmt);
+    }
+  }
+}
+
+void FunctionCompiler::statement(const lox::parser::Statement* stmt) {
+  auto& a = assembler_;
+  if (auto expression =
+          dynamic_cast<const lox::parser::StatementExpression*>(stmt)) {
+    effect(expression->expression);
+  } else if (auto var = dynamic_cast<const lox::parser::Var*>(stmt)) {
+    if (!var->initializer) {
+      throw Unsupported();
+    }
+    number(var->initializer);
+    a.store(local(var->binding));
+  } else if (auto block = dynamic_cast<const lox::parser::Block*>(stmt)) {
+    statements(block->statements);
+  } else if (auto branchIf = dynamic_cast<const lox::parser::If*>(stmt)) {
+    Label alternative = a.newLabel();
+    Label end = a.newLabel();
+    branch(branchIf->predicate, false, alternative);
+    statement(branchIf->then);
+    a.jump(end);
+    a.bind(alternative);
+    if (branchIf->alternative) {
+      statement(branchIf->alternative);
+    }
+    a.bind(end);
+  } else if (auto loop = dynamic_cast<const lox::parser::While*>(stmt)) {
+    loops_.push_back({a.newLabel(), a.newLabel()});
+    a.bind(loops_.back().start);
+    if (loop->condition) {
+      branch(loop->condition, false, loops_.back().end);
+    }
+    statement(loop->body);
+    a.jump(loops_.back().start);
+    a.bind(loops_.back().end);
+    loops_.pop_back();
+  } else if (dynamic_cast<const lox::parser::Continue*>(stmt)) {
+    if (loops_.empty()) {
+      throw Unsupported();
+    }
+    a.jump(loops_.back().start);
+  } else if (dynamic_cast<const lox::parser::Break*>(stmt)) {
+    if (loops_.empty()) {
+      throw Unsupported();
+    }
+    a.jump(loops_.back().end);
+  } else if (auto ret = dynamic_cast<const lox::parser::Return*>(stmt)) {
+    if (!ret->value) {
+      throw Unsupported();
+    }
+    number(ret->value);
+    // movsd [r12], xmm0
+    a.emit({0xF2, 0x41, 0x0F, 0x11, 0x04, 0x24});
+    a.jump(return_);
+  } else {
+    throw Unsupported();
+  }
+}
+
+void FunctionCompiler::effect(const lox::parser::Expression* expr) {
+  expr = unwrap(expr);
+  if (auto assignment = dynamic_cast<const lox::parser::Assignment*>(expr)) {
+    number(assignment->target);
+    assembler_.store(local(assignment->binding));
+  } else if (auto sequence =
+                 dynamic_cast<const lox::parser::Sequence*>(expr)) {
+    for (auto ex : sequence->expressions) {
+      effect(ex);
+    }
+  } else {
+    number(expr);
+  }
+}
+
+void FunctionCompiler::number(const lox::parser::Expression* expr) {
+  auto& a = assembler_;
+  expr = unwrap(expr);
+  if (auto literal = dynamic_cast<const lox::parser::Literal*>(expr)) {
+    if (!literal->value.isNumber()) {
+      throw Unsupported();
+    }
+    a.constant(0, literal->value.asNumber());
+  } else if (auto variable = dynamic_cast<const lox::parser::Variable*>(expr)) {
+    a.load(0, local(variable->binding));
+  } else if (auto unary = dynamic_cast<const lox::parser::Unary*>(expr)) {
+    number(unary->right);
+    switch (unary->op.type) {
+      case TT::MINUS:
+        a.constant(1, -0.0);
+        a.xorpd(0, 1);
+        break;
+      case TT::PLUS_PLUS:
+        a.constant(1, 1);
+        a.addsd(0, 1);
+        break;
+      case TT::MINUS_MINUS:
+        a.constant(1, 1);
+        a.subsd(0, 1);
+        break;
+      default:
+        throw Unsupported();
+    }
+  } else if (auto binary = dynamic_cast<const lox::parser::Binary*>(expr)) {
+    switch (binary->op.type) {
+      case TT::PLUS:
+        operands(binary);
+        a.addsd(0, 1);
+        break;
+      case TT::MINUS:
+        operands(binary);
+        a.subsd(0, 1);
+        break;
+      case TT::STAR:
+        operands(binary);
+        a.mulsd(0, 1);
+        break;
+      case TT::SLASH: {
+        operands(binary);
+        Label divide = a.newLabel();
+        a.xorpd(2, 2);
+        a.ucomisd(1, 2);
+        a.jump(kParity, divide);
+        a.jump(kEqual, bailout_);
+        a.bind(divide);
+        a.divsd(0, 1);
+        break;
+      }
+      default:
+        // Comparisons and logical operators yield booleans.
+        throw Unsupported();
+    }
+  } else if (auto ternary = dynamic_cast<const lox::parser::Ternary*>(expr)) {
+    if (!ternary->alternative) {
+      throw Unsupported();
+    }
+    Label alternative = a.newLabel();
+    Label end = a.newLabel();
+    branch(ternary->predicate, false, alternative);
+    number(ternary->then);
+    a.jump(end);
+    a.bind(alternative);
+    number(ternary->alternative);
+    a.bind(end);
+  } else if (auto sequence = dynamic_cast<const lox::parser::Sequence*>(expr)) {
+    if (sequence->expressions.size() == 0) {
+      throw Unsupported();
+    }
+    for (size_t i = 0; i + 1 < sequence->expressions.size(); i++) {
+      effect(sequence->expressions[i]);
+    }
+    number(sequence->expressions[sequence->expressions.size() - 1]);
+  } else if (auto callExpr = dynamic_cast<const lox::parser::Call*>(expr)) {
+    call(callExpr);
+  } else {
+    throw Unsupported();
+  }
+}
+
+void FunctionCompiler::operands(const lox::parser::Binary* expr) {
+  auto& a = assembler_;
+  number(expr->left);
+  // Literals and locals load straight into xmm1, anything else is
+  // evaluated with the left operand saved on the stack.
+  auto right = unwrap(expr->right);
+  auto literal = dynamic_cast<const lox::parser::Literal*>(right);
+  if (literal && literal->value.isNumber()) {
+    a.constant(1, literal->value.asNumber());
+  } else if (auto variable =
+                 dynamic_cast<const lox::parser::Variable*>(right)) {
+    a.load(1, local(variable->binding));
+  } else {
+    a.push();
+    number(right);
+    a.movapd(1, 0);
+    a.pop(0);
+  }
+}
+
+void FunctionCompiler::branch(const lox::parser::Expression* expr,
+                              bool jumpIf, Label label) {
+  auto& a = assembler_;
+  expr = unwrap(expr);
+  if (auto literal = dynamic_cast<const lox::parser::Literal*>(expr)) {
+    if (literal->value.isTruthy() == jumpIf) {
+      a.jump(label);
+    }
+    return;
+  }
+  if (auto unary = dynamic_cast<const lox::parser::Unary*>(expr);
+      unary && unary->op.type == TT::BANG) {
+    branch(unary->right, !jumpIf, label);
+    return;
+  }
+
+  auto binary = dynamic_cast<const lox::parser::Binary*>(expr);
+  if (!binary) {
+    number(expr);
+    a.xorpd(1, 1);
+    a.ucomisd(0, 1);
+    branchEqual(!jumpIf, label);
+    return;
+  }
+
+  // ucomisd sets the flags of an unsigned comparison, which is false on
+  // NaN for `above` and `above or equal`. Less than compares the swapped
+  // operands.
+  Condition condition;
+  switch (binary->op.type) {
+    case TT::AND:
+    case TT::OR: {
+      bool isOr = binary->op.type == TT::OR;
+      if (jumpIf == isOr) {
+        branch(binary->left, jumpIf, label);
+        branch(binary->right, jumpIf, label);
+      } else {
+        Label skip = a.newLabel();
+        branch(binary->left, !jumpIf, skip);
+        branch(binary->right, jumpIf, label);
+        a.bind(skip);
+      }
+      return;
+    }
+    case TT::EQUAL_EQUAL:
+    case TT::BANG_EQUAL:
+      operands(binary);
+      a.ucomisd(0, 1);
+      branchEqual((binary->op.type == TT::EQUAL_EQUAL) == jumpIf, label);
+      return;
+    case TT::GREATER:
+      operands(binary);
+      a.ucomisd(0, 1);
+      condition = kAbove;
+      break;
+    case TT::GREATER_EQUAL:
+      operands(binary);
+      a.ucomisd(0, 1);
+      condition = kAboveEqual;
+      break;
+    case TT::LESS:
+      operands(binary);
+      a.ucomisd(1, 0);
+      condition = kAbove;
+      break;
+    case TT::LESS_EQUAL:
+      operands(binary);
+      a.ucomisd(1, 0);
+      condition = kAboveEqual;
+      break;
+    default:
+      number(expr);
+      a.xorpd(1, 1);
+      a.ucomisd(0, 1);
+      branchEqual(!jumpIf, label);
+      return;
+  }
+  a.jump(jumpIf ? condition : negate(condition), label);
+}
+
+void FunctionCompiler::branchEqual(bool equal, Label label) {
+  auto& a = assembler_;
+  if (equal) {
+    Label unordered = a.newLabel();
+    a.jump(kParity, unordered);
+    a.jump(kEqual, label);
+    a.bind(unordered);
+  } else {
+    a.jump(kParity, label);
+    a.jump(kNotEqual, label);
+  }
+}
+
+void FunctionCompiler::call(const lox::parser::Call* expr) {
+  auto& a = assembler_;
+  auto variable =
+      dynamic_cast<const lox::parser::Variable*>(unwrap(expr->callee));
+  if (!variable ||
+      variable->binding.kind != lox::parser::Binding::Kind::Global) {
+    throw Unsupported();
+  }
+  int index = variable->binding.index;
+  Value callee = globals_.values()[index];
+  if (!callee.isObject(ObjectType::Function)) {
+    throw Unsupported();
+  }
+  auto function = callee.as<LoxFunction>();
+  auto arguments = dynamic_cast<const lox::parser::Sequence*>(expr->arguments);
+  size_t argCount = arguments ? arguments->expressions.size() : 0;
+  if (function->isBound() || argCount != function->arity()) {
+    throw Unsupported();
+  }
+  NativeCode code = nullptr;
+  if (function->declaration() != declaration_) {
+    code = jit_.compile(function->declaration(), globals_);
+    if (!code) {
+      throw Unsupported();
+    }
+  }
+  callees_.push_back(callee);
+
+  // Bail out unless the global still holds the function:
+  // mov rax, [rbx]; mov rax, [rax + 8 * index]; mov rcx, bits; cmp rax, rcx
+  uint64_t bits;
+  std::memcpy(&bits, &callee, sizeof(bits));
+  a.emit({0x48, 0x8B, 0x03, 0x48, 0x8B, 0x80});
+  a.emit32(8 * index);
+  a.emit({0x48, 0xB9});
+  a.emit64(bits);
+  a.emit({0x48, 0x39, 0xC8});
+  a.jump(kNotEqual, bailout_);
+
+  // The result slot, then the arguments below it, first argument lowest.
+  a.emit({0x48, 0x83, 0xEC, 0x08});
+  for (size_t i = argCount; i-- > 0;) {
+    number(arguments->expressions[i]);
+    a.push();
+  }
+  // mov rdi, rsp; lea rsi, [rsp + 8 * argCount]; mov rdx, rbx
+  a.emit({0x48, 0x89, 0xE7, 0x48, 0x8D, 0xB4, 0x24});
+  a.emit32(8 * argCount);
+  a.emit({0x48, 0x89, 0xDA});
+  if (code) {
+    a.call(reinterpret_cast<const void*>(code));
+  } else {
+    a.call(entry_);
+  }
+  // test al, al; je bailout
+  a.emit({0x84, 0xC0});
+  a.jump(kEqual, bailout_);
+  // movsd xmm0, [rsp + 8 * argCount]; add rsp, 8 * argCount + 8
+  a.emit({0xF2, 0x0F, 0x10, 0x84, 0x24});
+  a.emit32(8 * argCount);
+  a.emit({0x48, 0x81, 0xC4});
+  a.emit32(8 * argCount + 8);
+}
+
+int32_t FunctionCompiler::local(const lox::parser::Binding& binding) const {
+  if (binding.kind != lox::parser::Binding::Kind::Local ||
+      binding.index >= declaration_->slots) {
+    throw Unsupported();
+  }
+  return slot(binding.index);
+}
+
+Jit::~Jit() {
+  for (const auto& region : regions_) {
+    munmap(region.address, region.size);
+  }
+  for (const auto& callee : callees_) {
+    heap().unpin(callee);
+  }
+  if (perfMap_) {
+    fclose(perfMap_);
+  }
+}
+
+bool Jit::supported() { return true; }
+
+NativeCode Jit::compile(const lox::parser::Function* declaration,
+                        const Globals& globals) {
+  if (declaration->jit.code) {
+    return declaration->jit.code;
+  }
+  // Mutually recursive functions would need each other's code first.
+  if (declaration->jit.disabled ||
+      std::find(compiling_.begin(), compiling_.end(), declaration) !=
+          compiling_.end()) {
+    return nullptr;
+  }
+
+  compiling_.push_back(declaration);
+  FunctionCompiler compiler(*this, declaration, globals);
+  std::vector<uint8_t> code;
+  bool compiled = compiler.compile(code);
+  compiling_.pop_back();
+  if (!compiled) {
+    return nullptr;
+  }
+
+  void* address = install(code);
+  if (!address) {
+    return nullptr;
+  }
+  for (const auto& callee : compiler.callees()) {
+    heap().pin(callee);
+    callees_.push_back(callee);
+  }
+  writePerfMap(address, code.size(), declaration);
+  declaration->jit.code = reinterpret_cast<NativeCode>(address);
+  return declaration->jit.code;
+}
+
+void* Jit::install(const std::vector<uint8_t>& code) {
+  size_t page = sysconf(_SC_PAGESIZE);
+  size_t size = (code.size() + page - 1) / page * page;
+  void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (address == MAP_FAILED) {
+    return nullptr;
+  }
+  std::memcpy(address, code.data(), code.size());
+  if (mprotect(address, size, PROT_READ | PROT_EXEC) != 0) {
+    munmap(address, size);
+    return nullptr;
+  }
+  regions_.push_back({address, size});
+  return address;
+}
+
+void Jit::writePerfMap(const void* address, size_t size,
+                       const lox::parser::Function* declaration) {
+  if (!perfMap_) {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/perf-%d.map", getpid());
+    perfMap_ = fopen(path, "a");
+    if (!perfMap_) {
+      return;
+    }
+  }
+  const auto& name = declaration->name.lexeme;
+  fprintf(perfMap_, "%" PRIxPTR " %zx lox:%.*s\n",
+          reinterpret_cast<uintptr_t>(address), size,
+          static_cast<int>(name.size()), name.data());
+  // perf reads the map after the process exits, or while it runs.
+  fflush(perfMap_);
+}
+
+}  // namespace lang
+}  // namespace lox
+
+#else
+
+namespace lox {
+namespace lang {
+
+Jit::~Jit() {}
+
+bool Jit::supported() { return false; }
+
+NativeCode Jit::compile(const lox::parser::Function* declaration,
+                        const Globals& globals) {
+  return nullptr;
+}
+
+}  // namespace lang
+}  // namespace lox
+
+#endif
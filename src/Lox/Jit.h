@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "Value.h"
+
+namespace lox {
+namespace parser {
+struct Function;
+}  // namespace parser
+
+namespace lang {
+
+class Globals;
+class LoxFunction;
+
+// What compiled code needs from the interpreter: the global table, to check
+// the functions it calls are still the ones it was compiled against, and
+// how many more calls may nest before the stack overflows.
+struct JitContext {
+  const Value* globals;
+  int64_t depth;
+};
+
+// Compiled function. Takes the arguments, all numbers, and stores the
+// number it returns to `result`. Returns false instead when it bails out:
+// an operand that is not a number, a division by zero, a call that is not
+// to the function it was compiled against, too deep a recursion or falling
+// off the end without a return. Compiled code has no side effects, so the
+// interpreter runs the call again to give the answer or report the error.
+using NativeCode = bool (*)(const double* args, double* result,
+                            JitContext* context);
+
+// JIT state of a function declaration, shared by all of its closures.
+struct JitState {
+  uint32_t calls = 0;
+  uint32_t bailouts = 0;
+  NativeCode code = nullptr;
+  // The function can not be compiled, or bails out too often to be worth
+  // running compiled.
+  bool disabled = false;
+};
+
+// Baseline compiler from Lox functions to x86-64 machine code.
+//
+// It compiles numeric leaf code: functions taking and returning numbers
+// whose locals are all numbers, built from number literals, arithmetic,
+// comparisons, logical operators, if, while, assignments to locals and
+// calls to other compilable global functions, including themselves.
+// Anything else, e.g. strings, objects, closures, globals other than
+// callees, or print, makes compile() give up and the function stays
+// interpreted. Values live in the native frame as raw doubles, expressions
+// are evaluated on the native stack with xmm0 as the accumulator, there is
+// no register allocation.
+//
+// Every compiled function is listed in /tmp/perf-<pid>.map for perf to
+// symbolize. Only x86-64 Linux is supported, elsewhere compile() always
+// gives up.
+class Jit {
+ public:
+  static constexpr uint32_t kDefaultThreshold = 1000;
+  // Bailouts after which a compiled function is left to the interpreter.
+  static constexpr uint32_t kMaxBailouts = 16;
+
+  Jit() = default;
+  Jit(const Jit&) = delete;
+  Jit& operator=(const Jit&) = delete;
+  ~Jit();
+
+  static bool supported();
+
+  // Compiles `declaration`, and the global functions it calls, against the
+  // current contents of `globals`. Returns nullptr if it uses anything the
+  // JIT does not support.
+  NativeCode compile(const lox::parser::Function* declaration,
+                     const Globals& globals);
+
+ private:
+  struct Region {
+    void* address;
+    size_t size;
+  };
+
+  std::vector<Region> regions_;
+  // Functions the compiled code calls, pinned so that their addresses are
+  // not reused by other functions while the code checks against them.
+  std::vector<Value> callees_;
+  // Declarations being compiled, to tell recursion apart from cycles.
+  std::vector<const lox::parser::Function*> compiling_;
+  FILE* perfMap_ = nullptr;
+
+  void* install(const std::vector<uint8_t>& code);
+  void writePerfMap(const void* address, size_t size,
+                    const lox::parser::Function* declaration);
+
+  friend class FunctionCompiler;
+};
+
+}  // namespace lang
+}  // namespace lox
@@ -0,0 +1,42 @@
+#include "LineProfile.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace lox {
+namespace lang {
+
+std::vector<LineProfile::Line> LineProfile::hottest(size_t count) const {
+  std::vector<Line> lines;
+  for (size_t i = 0; i < lines_.size(); i++) {
+    if (lines_[i].executions || lines_[i].calls) {
+      lines.push_back(lines_[i]);
+      lines.back().line = i;
+    }
+  }
+  std::sort(lines.begin(), lines.end(), [](const Line& a, const Line& b) {
+    return a.time != b.time ? a.time > b.time : a.line < b.line;
+  });
+  if (lines.size() > count) {
+    lines.resize(count);
+  }
+  return lines;
+}
+
+void LineProfile::report(std::ostream& out, size_t count) const {
+  char row[96];
+  std::snprintf(row, sizeof(row), "%8s %14s %14s %12s\n", "line",
+                "executions", "calls", "time (ms)");
+  out << row;
+  for (const auto& line : hottest(count)) {
+    std::snprintf(
+        row, sizeof(row), "%8d %14llu %14llu %12.3f\n", line.line,
+        static_cast<unsigned long long>(line.executions),
+        static_cast<unsigned long long>(line.calls),
+        std::chrono::duration<double, std::milli>(line.time).count());
+    out << row;
+  }
+}
+
+}  // namespace lang
+}  // namespace lox
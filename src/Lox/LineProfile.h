@@ -0,0 +1,78 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace lox {
+namespace lang {
+
+// Execution counters of the tree walker, per source line. Every executed
+// statement and every call counts towards its line, together with the
+// time spent in it, including the statements and calls it runs in turn.
+// Time is inclusive per line: a line running again while it already runs,
+// in a loop or recursion on one line, is only timed once.
+class LineProfile {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Line {
+    int line = 0;
+    uint64_t executions = 0;
+    uint64_t calls = 0;
+    Clock::duration time{0};
+    // Statements and calls of the line in progress.
+    int active = 0;
+  };
+
+  enum class Kind { Statement, Call };
+
+  // Counts one execution of a statement or a call on `line` and times it
+  // until the scope ends, exceptions included.
+  class Scope {
+   public:
+    Scope(LineProfile& profile, int line, Kind kind)
+        : profile_(profile), line_(line) {
+      auto& counters = profile_.at(line_);
+      if (kind == Kind::Call) {
+        counters.calls++;
+      } else {
+        counters.executions++;
+      }
+      if (counters.active++ == 0) {
+        start_ = Clock::now();
+      }
+    }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+    ~Scope() {
+      auto& counters = profile_.at(line_);
+      if (--counters.active == 0) {
+        counters.time += Clock::now() - start_;
+      }
+    }
+
+   private:
+    LineProfile& profile_;
+    const int line_;
+    Clock::time_point start_;
+  };
+
+  // The lines that ran, the longest running first.
+  std::vector<Line> hottest(size_t count) const;
+  // Prints the `count` hottest lines as a table.
+  void report(std::ostream& out, size_t count) const;
+
+ private:
+  std::vector<Line> lines_;
+
+  Line& at(int line) {
+    if (static_cast<size_t>(line) >= lines_.size()) {
+      lines_.resize(line + 1);
+    }
+    return lines_[line];
+  }
+};
+
+}  // namespace lang
+}  // namespace lox
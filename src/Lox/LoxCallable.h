@@ -1,15 +1,18 @@
 #pragma once
-#include <vector>
-
 #include "Interpreter.h"
+#include "LoxObject.h"
+#include "Value.h"
 
 namespace lox {
 namespace lang {
 
-class LoxCallable {
+class LoxCallable : public LoxObject {
  public:
-  virtual std::any call(Interpreter& interpreter,
-                        const std::vector<std::any>& args) = 0;
+  using LoxObject::LoxObject;
+  // `args` points at the `argCount` arguments in the stack of the
+  // interpreter, right after the callee. It is only valid until the callee
+  // runs Lox code, which may grow the stack.
+  virtual Value call(Interpreter& interpreter, Value* args, int argCount) = 0;
   virtual int arity() const = 0;
   virtual ~LoxCallable() = default;
 };
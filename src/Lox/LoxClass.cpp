@@ -4,33 +4,27 @@ namespace lox {
 namespace lang {
 
 int LoxClass::arity() const {
-  auto init = getMethod("init");
-  if (init) {
-    return init->arity();
-  }
-  return 0;
+  return initializer_ ? initializer_->arity() : 0;
 }
 
-std::any LoxClass::call(Interpreter& interpreter,
-                        const std::vector<std::any>& args) {
-  auto instance = std::make_shared<LoxInstance>(shared_from_this());
-  std::shared_ptr<LoxFunction> initializer = getMethod("init");
-  if (initializer != nullptr) {
-    initializer->bind(instance)->call(interpreter, args);
+Value LoxClass::call(Interpreter& interpreter, Value* args, int argCount) {
+  auto instance = makeObject<LoxInstance>(this);
+  if (initializer_ != nullptr) {
+    initializer_->invoke(interpreter, instance, argCount);
   }
   return instance;
 }
 
-std::shared_ptr<LoxFunction> LoxClass::getMethod(
-    const std::string& name) const {
+LoxFunction* LoxClass::getMethod(std::string_view name) const {
   auto it = methods_.find(name);
-  if (it != methods_.end()) {
-    return it->second;
-  }
-  if (superclass_) {
-    return superclass_->getMethod(name);
+  return it != methods_.end() ? it->second : nullptr;
+}
+
+void LoxClass::trace(Heap& heap) const {
+  heap.mark(superclass_);
+  for (const auto& [name, method] : methods_) {
+    heap.mark(method);
   }
-  return nullptr;
 }
 
 std::string LoxClass::toString() const { return "Class " + name_; }
@@ -1,35 +1,53 @@
 #pragma once
-#include <any>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 #include "Interpreter.h"
 #include "LoxCallable.h"
 #include "LoxFunction.h"
 #include "LoxInstance.h"
+#include "LoxObject.h"
 
 namespace lox {
 namespace lang {
-class LoxClass : public LoxCallable,
-                 public std::enable_shared_from_this<LoxClass> {
+// Method tables are keyed by interned names, see lox::parser::SymbolTable.
+// A class's table is flattened: it holds the inherited methods as well.
+using MethodTable = std::unordered_map<std::string_view, LoxFunction*>;
+
+class LoxClass : public LoxCallable {
  public:
   friend class LoxInstance;
-  LoxClass(const std::string& name, const std::shared_ptr<LoxClass>& superclass,
-           const std::unordered_map<std::string, std::shared_ptr<LoxFunction>>&
-               methods)
-      : name_{name}, superclass_(superclass), methods_(std::move(methods)) {}
+  LoxClass(std::string_view name, LoxClass* superclass, MethodTable methods)
+      : LoxCallable(ObjectType::Class),
+        id_(nextId()),
+        name_{name},
+        superclass_(superclass),
+        methods_(std::move(methods)),
+        initializer_(getMethod("init")) {}
 
   int arity() const override;
-  std::any call(Interpreter& interpreter,
-                const std::vector<std::any>& args) override;
+  Value call(Interpreter& interpreter, Value* args, int argCount) override;
 
-  std::shared_ptr<LoxFunction> getMethod(const std::string& name) const;
-  std::string toString() const;
+  // Unique for the lifetime of the process, unlike the address.
+  uint64_t id() const { return id_; }
+  LoxFunction* getMethod(std::string_view name) const;
+  const MethodTable& methods() const { return methods_; }
+  std::string toString() const override;
+  void trace(Heap& heap) const override;
 
  private:
+  static uint64_t nextId() {
+    static uint64_t id = 0;
+    return ++id;
+  }
+
+  const uint64_t id_;
   const std::string name_;
-  const std::shared_ptr<LoxClass> superclass_;
-  const std::unordered_map<std::string, std::shared_ptr<LoxFunction>> methods_;
+  LoxClass* const superclass_;
+  const MethodTable methods_;
+  LoxFunction* const initializer_;
 };
 }  // namespace lang
 }  // namespace lox
\ No newline at end of file
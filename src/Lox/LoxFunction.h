@@ -1,71 +1,79 @@
 #pragma once
 
-#include <any>
 #include <vector>
 
-#include "ControlException.h"
 #include "Environment.h"
+#include "Heap.h"
 #include "Interpreter.h"
 #include "LoxCallable.h"
 #include "LoxInstance.h"
+#include "LoxObject.h"
 #include "RuntimeError.h"
 #include "Statement.h"
 
 namespace lox {
 namespace lang {
+// A function, or a method of a class. A closure keeps the cells of the
+// variables it captures from enclosing functions, its upvalues, and nothing
+// else of the scopes it was created in. Methods take their receiver, "this",
+// in the first slot of the call frame. The methods in a class are unbound;
+// invoke() passes them the receiver of the call. A method only becomes a
+// bound function of its own, carrying the receiver, when it is used as a
+// value, e.g. `var f = object.method;`.
 class LoxFunction : public LoxCallable {
  public:
-  LoxFunction(const std::shared_ptr<const lox::parser::Function>& declaration,
-              std::shared_ptr<Environment> closure, bool isInitializer = false)
-      : declaration_(std::move(declaration)),
-        closure_(closure),
-        isInitializer_(isInitializer) {}
+  LoxFunction(const lox::parser::Function* declaration,
+              std::vector<Cell*> upvalues, bool isInitializer = false,
+              LoxInstance* receiver = nullptr)
+      : LoxCallable(ObjectType::Function),
+        declaration_(declaration),
+        upvalues_(std::move(upvalues)),
+        isInitializer_(isInitializer),
+        receiver_(receiver) {}
 
-  std::any call(Interpreter& interpreter,
-                const std::vector<std::any>& args) override {
-    auto env = std::make_shared<Environment>(closure_);
-    for (int i = 0; i < declaration_->parameters.size(); i++) {
-      auto arg = args[i];
-      env->define(declaration_->parameters[i].lexeme, arg);
-    }
-    try {
-      interpreter.evaluate(declaration_->body, env);
-    } catch (Return& return_exception) {
-      if (isInitializer_) {
-        return closure_->getAt(
-            lox::parser::Token(lox::parser::Token::TokenType::THIS, "this",
-                               declaration_->name.line),
-            0);
-      }
-      return return_exception.value;
-    }
+  Value call(Interpreter& interpreter, Value* args, int argCount) override {
+    return invoke(interpreter, receiver_, argCount);
+  }
+
+  // Calls the function on the callee slot and the `argCount` arguments on
+  // top of the stack of the interpreter, with `receiver` as "this" if it is
+  // a method.
+  Value invoke(Interpreter& interpreter, LoxInstance* receiver, int argCount) {
+    Value result = interpreter.call(this, receiver, argCount);
 
-    if (isInitializer_)
-      return closure_->getAt(
-          lox::parser::Token(lox::parser::Token::TokenType::THIS, "this",
-                             declaration_->name.line),
-          0);
+    // Initializers always return "this".
+    if (isInitializer_) return receiver;
 
-    return nullptr;
+    return result;
   }
 
   int arity() const override { return declaration_->parameters.size(); }
 
-  std::shared_ptr<LoxFunction> bind(std::shared_ptr<LoxInstance> instance) {
-    auto environment = std::make_shared<Environment>(closure_);
-    environment->define("this", instance);
-    return std::make_shared<LoxFunction>(declaration_, environment,
-                                         isInitializer_);
+  LoxFunction* bind(LoxInstance* instance) {
+    return makeObject<LoxFunction>(declaration_, upvalues_, isInitializer_,
+                                   instance);
   }
 
-  std::string toString() const {
-    return "Function " + declaration_->name.lexeme;
+  const lox::parser::Function* declaration() const { return declaration_; }
+  bool isBound() const { return receiver_ != nullptr; }
+  Cell* upvalue(int index) const { return upvalues_[index]; }
+
+  std::string toString() const override {
+    return "Function " + std::string(declaration_->name.lexeme);
+  }
+  void trace(Heap& heap) const override {
+    for (auto upvalue : upvalues_) {
+      heap.mark(upvalue);
+    }
+    heap.mark(receiver_);
   }
 
  private:
-  const std::shared_ptr<const lox::parser::Function> declaration_;
-  std::shared_ptr<Environment> closure_;
+  const lox::parser::Function* const declaration_;
+  const std::vector<Cell*> upvalues_;
   bool isInitializer_;
+  // Receiver of a bound method, nullptr otherwise.
+  LoxInstance* const receiver_;
 };
 }  // namespace lang
 }  // namespace lox
\ No newline at end of file
@@ -5,22 +5,91 @@
 namespace lox {
 namespace lang {
 
-std::any LoxInstance::get(const lox::parser::Token& name) {
-  auto it = fields_.find(name.lexeme);
-  if (it != fields_.end()) {
-    return it->second;
+Value LoxInstance::get(const lox::parser::Token& name) {
+  int slot = shape_->lookup(name.lexeme);
+  if (slot >= 0) {
+    return fields_[slot];
   }
 
   auto method = klass_->getMethod(name.lexeme);
   if (method) {
-    return method->bind(shared_from_this());
+    return method->bind(this);
   }
 
   throw RuntimeError(name, std::string(kUndefinedProperty));
 }
 
-void LoxInstance::set(const lox::parser::Token& name, std::any& value) {
-  fields_.insert_or_assign(name.lexeme, value);
+void LoxInstance::set(const lox::parser::Token& name, const Value& value) {
+  int slot = shape_->lookup(name.lexeme);
+  if (slot >= 0) {
+    fields_[slot] = value;
+    return;
+  }
+  shape_ = shape_->withField(name.lexeme);
+  fields_.push_back(value);
+}
+
+Value LoxInstance::get(const lox::parser::Token& name, PropertyCache& cache) {
+  Value field;
+  auto method = resolve(name, cache, field);
+  return method ? method->bind(this) : field;
+}
+
+LoxFunction* LoxInstance::resolve(const lox::parser::Token& name,
+                                  PropertyCache& cache, Value& field) {
+  if (auto entry = cache.find(shape_, klass_->id())) {
+    if (entry->method) {
+      return entry->method;
+    }
+    field = fields_[entry->slot];
+    return nullptr;
+  }
+
+  int slot = shape_->lookup(name.lexeme);
+  if (slot >= 0) {
+    cache.add({shape_, 0, slot, nullptr, nullptr});
+    field = fields_[slot];
+    return nullptr;
+  }
+
+  auto method = klass_->getMethod(name.lexeme);
+  if (method) {
+    cache.add({shape_, klass_->id(), -1, method, nullptr});
+    return method;
+  }
+
+  throw RuntimeError(name, std::string(kUndefinedProperty));
+}
+
+void LoxInstance::set(const lox::parser::Token& name, const Value& value,
+                      PropertyCache& cache) {
+  if (auto entry = cache.find(shape_, 0)) {
+    if (entry->next) {
+      shape_ = entry->next;
+      fields_.push_back(value);
+    } else {
+      fields_[entry->slot] = value;
+    }
+    return;
+  }
+
+  int slot = shape_->lookup(name.lexeme);
+  if (slot >= 0) {
+    cache.add({shape_, 0, slot, nullptr, nullptr});
+    fields_[slot] = value;
+    return;
+  }
+  auto next = shape_->withField(name.lexeme);
+  cache.add({shape_, 0, static_cast<int>(fields_.size()), nullptr, next});
+  shape_ = next;
+  fields_.push_back(value);
+}
+
+void LoxInstance::trace(Heap& heap) const {
+  heap.mark(klass_);
+  for (const auto& value : fields_) {
+    heap.mark(value);
+  }
 }
 
 std::string LoxInstance::toString() const {
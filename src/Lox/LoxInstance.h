@@ -1,31 +1,56 @@
 #pragma once
-#include <any>
-#include <memory>
+#include <folly/small_vector.h>
+
 #include <string>
 #include <string_view>
-#include <unordered_map>
 
+#include "Heap.h"
+#include "InlineCache.h"
+#include "LoxObject.h"
 #include "RuntimeError.h"
+#include "Shape.h"
+#include "Value.h"
 
 constexpr std::string_view kUndefinedProperty = "Undefined property";
 
 namespace lox {
 namespace lang {
 class LoxClass;
+class LoxFunction;
 class Token;
 
-class LoxInstance : public std::enable_shared_from_this<LoxInstance> {
+class LoxInstance : public LoxObject {
  public:
-  LoxInstance(std::shared_ptr<LoxClass> klass) : klass_(std::move(klass)) {}
-
-  std::any get(const lox::parser::Token& name);
-  void set(const lox::parser::Token& name, std::any& value);
-
-  std::string toString() const;
+  explicit LoxInstance(LoxClass* klass)
+      : LoxObject(ObjectType::Instance),
+        klass_(klass),
+        shape_(Shape::empty()) {}
+
+  Value get(const lox::parser::Token& name);
+  void set(const lox::parser::Token& name, const Value& value);
+  // Same as above, resolving the name through the inline cache of the
+  // accessing site first.
+  Value get(const lox::parser::Token& name, PropertyCache& cache);
+  void set(const lox::parser::Token& name, const Value& value,
+           PropertyCache& cache);
+  // Looks `name` up without binding methods: returns the method if it names
+  // one, otherwise stores the field value in `field` and returns nullptr.
+  LoxFunction* resolve(const lox::parser::Token& name, PropertyCache& cache,
+                       Value& field);
+
+  const Shape* shape() const { return shape_; }
+
+  std::string toString() const override;
+  void trace(Heap& heap) const override;
 
  private:
-  std::shared_ptr<const LoxClass> klass_;
-  std::unordered_map<std::string, std::any> fields_;
+  // Fields most instances have fit in the object itself.
+  static constexpr size_t kInlineFields = 4;
+
+  LoxClass* const klass_;
+  Shape* shape_;
+  // Field values, in the slots assigned by shape_.
+  folly::small_vector<Value, kInlineFields> fields_;
 };
 
 }  // namespace lang
@@ -9,14 +9,16 @@ namespace lang {
 
 class Clock : public LoxCallable {
  public:
-  std::any call(Interpreter& interpreter,
-                const std::vector<std::any>& args) override {
+  Clock() : LoxCallable(ObjectType::Native) {}
+
+  Value call(Interpreter& interpreter, Value* args, int argCount) override {
     return std::chrono::duration<double>(
                std::chrono::duration_cast<std::chrono::milliseconds>(
                    std::chrono::system_clock::now().time_since_epoch()))
         .count();
   }
   int arity() const override { return 0; }
+  std::string toString() const override { return "Native Function clock"; }
 };
 }  // namespace lang
 
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace lox {
+namespace lang {
+
+class Heap;
+
+enum class ObjectType : uint8_t {
+  String,
+  Function,
+  Native,
+  Class,
+  Instance,
+  Cell,
+  VmFunction,
+  VmNative,
+  VmClosure,
+  VmUpvalue,
+  VmClass,
+  VmInstance,
+  VmBoundMethod,
+};
+
+// Base class of every heap allocated Lox value. Objects are owned by the
+// Heap, which links them into one list and frees the unreachable ones in a
+// mark-sweep collection. A Value keeps a bare pointer in its NaN box.
+class LoxObject {
+ public:
+  explicit LoxObject(ObjectType type)
+      : type_(type), marked_(false), size_(0), next_(nullptr) {}
+  LoxObject(const LoxObject&) = delete;
+  LoxObject& operator=(const LoxObject&) = delete;
+  virtual ~LoxObject() = default;
+
+  ObjectType type() const { return type_; }
+  virtual std::string toString() const = 0;
+
+  // Marks every object directly referenced by this one.
+  virtual void trace(Heap& heap) const {}
+  // Memory owned outside the object itself, counted towards the heap size.
+  virtual size_t extraBytes() const { return 0; }
+
+ private:
+  friend class Heap;
+
+  const ObjectType type_;
+  bool marked_;
+  uint32_t size_;
+  LoxObject* next_;
+};
+
+}  // namespace lang
+}  // namespace lox
@@ -0,0 +1,91 @@
+#include "LoxString.h"
+
+#include <vector>
+
+#include "Heap.h"
+#include "utils.h"
+
+namespace lox {
+namespace lang {
+
+LoxString::~LoxString() {
+  if (interned_) {
+    strings().remove(this);
+  }
+}
+
+void LoxString::trace(Heap& heap) const {
+  heap.mark(const_cast<LoxString*>(left_));
+  heap.mark(const_cast<LoxString*>(right_));
+}
+
+void LoxString::flatten() const {
+  // Ropes built in a loop nest thousands of levels deep on the left, walk
+  // them with an explicit stack.
+  std::string result;
+  result.reserve(length_);
+  std::vector<const LoxString*> pending{right_, left_};
+  while (!pending.empty()) {
+    const LoxString* string = pending.back();
+    pending.pop_back();
+    if (string->left_) {
+      pending.push_back(string->right_);
+      pending.push_back(string->left_);
+    } else {
+      result += string->value_;
+    }
+  }
+  value_ = std::move(result);
+  left_ = nullptr;
+  right_ = nullptr;
+  heap().grow(const_cast<LoxString*>(this), value_.capacity());
+}
+
+LoxString* StringTable::intern(std::string_view value) {
+  auto it = strings_.find(value);
+  if (it != strings_.end()) {
+    return it->second;
+  }
+  auto string = makeObject<LoxString>(std::string(value));
+  string->interned_ = true;
+  strings_.emplace(string->value(), string);
+  return string;
+}
+
+void StringTable::remove(const LoxString* string) {
+  auto it = strings_.find(string->value());
+  if (it != strings_.end() && it->second == string) {
+    strings_.erase(it);
+  }
+}
+
+LoxString* concatenate(const Value& left, const Value& right) {
+  auto length = [](const Value& value) -> size_t {
+    return value.isString() ? value.as<LoxString>()->length() : 0;
+  };
+  if (length(left) + length(right) >= kMinRopeLength) {
+    auto string = [](const Value& value) {
+      return value.isString()
+                 ? value.as<LoxString>()
+                 : makeObject<LoxString>(lox::util::to_string(value));
+    };
+    return makeObject<LoxString>(string(left), string(right));
+  }
+
+  // Strings are appended in place, only other operands are printed first.
+  auto append = [](std::string& result, const Value& value) {
+    if (value.isString()) {
+      result += value.as<LoxString>()->value();
+    } else {
+      result += lox::util::to_string(value);
+    }
+  };
+  std::string result;
+  result.reserve(length(left) + length(right));
+  append(result, left);
+  append(result, right);
+  return makeObject<LoxString>(std::move(result));
+}
+
+}  // namespace lang
+}  // namespace lox
@@ -0,0 +1,133 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "LoxObject.h"
+#include "Value.h"
+
+namespace lox {
+namespace lang {
+
+// 32 bit FNV-1a, the hash LoxString caches.
+inline uint32_t hashString(std::string_view chars) {
+  uint32_t hash = 2166136261u;
+  for (char c : chars) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// Immutable Lox string. The hash of its characters is computed once. Strings
+// made by intern() are unique per content, two interned strings are equal
+// exactly if they are the same object.
+//
+// A long concatenation is a rope: it only references its two operands and
+// copies their characters once something reads them through value(), so
+// building a string piece by piece takes linear time. Flattening releases
+// the operands.
+class LoxString : public LoxObject {
+ public:
+  explicit LoxString(std::string value)
+      : LoxObject(ObjectType::String),
+        value_(std::move(value)),
+        length_(value_.size()),
+        left_(nullptr),
+        right_(nullptr),
+        hashed_(false),
+        interned_(false) {}
+  // The rope of `left + right`.
+  LoxString(LoxString* left, LoxString* right)
+      : LoxObject(ObjectType::String),
+        length_(left->length_ + right->length_),
+        left_(left),
+        right_(right),
+        hashed_(false),
+        interned_(false) {}
+  ~LoxString() override;
+
+  const std::string& value() const {
+    if (left_) {
+      flatten();
+    }
+    return value_;
+  }
+  size_t length() const { return length_; }
+  bool isRope() const { return left_ != nullptr; }
+  uint32_t hash() const {
+    if (!hashed_) {
+      hash_ = hashString(value());
+      hashed_ = true;
+    }
+    return hash_;
+  }
+  bool interned() const { return interned_; }
+
+  bool equals(const LoxString* other) const {
+    if (this == other) {
+      return true;
+    }
+    if ((interned_ && other->interned_) || length_ != other->length_) {
+      return false;
+    }
+    return hash() == other->hash() && value() == other->value();
+  }
+
+  std::string toString() const override { return value(); }
+  void trace(Heap& heap) const override;
+  size_t extraBytes() const override { return value_.capacity(); }
+
+ private:
+  friend class StringTable;
+
+  mutable std::string value_;
+  const size_t length_;
+  // Operands of a rope until it is flattened.
+  mutable const LoxString* left_;
+  mutable const LoxString* right_;
+  mutable uint32_t hash_;
+  mutable bool hashed_;
+  bool interned_;
+
+  void flatten() const;
+};
+
+// Interned strings: literals of the program and names in VM constants. The
+// table does not keep its strings alive, a string the collector frees
+// removes itself.
+class StringTable {
+ public:
+  // The interned string with the characters of `value`, made if needed.
+  LoxString* intern(std::string_view value);
+  void remove(const LoxString* string);
+
+  size_t size() const { return strings_.size(); }
+
+ private:
+  struct Hash {
+    size_t operator()(std::string_view chars) const {
+      return hashString(chars);
+    }
+  };
+
+  // Keys view the characters of their string.
+  std::unordered_map<std::string_view, LoxString*, Hash> strings_;
+};
+
+// Table shared by every interpreter and VM, never destroyed like the heap.
+inline StringTable& strings() {
+  static auto* table = new StringTable();
+  return *table;
+}
+
+// Results of concatenations at least this long are ropes, shorter ones are
+// copied right away.
+constexpr size_t kMinRopeLength = 256;
+
+// `left + right` with either operand a string and the other one printed.
+LoxString* concatenate(const Value& left, const Value& right);
+
+}  // namespace lang
+}  // namespace lox
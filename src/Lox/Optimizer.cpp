@@ -0,0 +1,386 @@
+#include "Optimizer.h"
+
+#include "Heap.h"
+#include "LoxString.h"
+#include "utils.h"
+
+namespace lox {
+namespace lang {
+
+namespace {
+
+using TT = lox::parser::Token::TokenType;
+
+const lox::parser::Literal* asLiteral(const lox::parser::Expression* expr) {
+  return dynamic_cast<const lox::parser::Literal*>(expr);
+}
+
+// Computes `left op right` the way the engines do, false if the operation
+// fails at runtime or is not an arithmetic, comparison or equality operator.
+bool foldBinary(TT op, const Value& left, const Value& right, Value& result) {
+  switch (op) {
+    case TT::EQUAL_EQUAL:
+      result = left.equals(right);
+      return true;
+    case TT::BANG_EQUAL:
+      result = !left.equals(right);
+      return true;
+    case TT::PLUS:
+      if (!(left.isNumber() && right.isNumber()) &&
+          (left.isString() || right.isString())) {
+        // A constant like any other string literal, interned as well.
+        result = strings().intern(lox::util::to_string(left) +
+                                  lox::util::to_string(right));
+        return true;
+      }
+      break;
+    default:
+      break;
+  }
+
+  if (!left.isNumber() || !right.isNumber()) {
+    return false;
+  }
+  double a = left.asNumber();
+  double b = right.asNumber();
+  switch (op) {
+    case TT::GREATER:
+      result = a > b;
+      return true;
+    case TT::GREATER_EQUAL:
+      result = a >= b;
+      return true;
+    case TT::LESS:
+      result = a < b;
+      return true;
+    case TT::LESS_EQUAL:
+      result = a <= b;
+      return true;
+    case TT::PLUS:
+      result = a + b;
+      return true;
+    case TT::MINUS:
+      result = a - b;
+      return true;
+    case TT::STAR:
+      result = a * b;
+      return true;
+    case TT::SLASH:
+      if (b == 0) {
+        return false;
+      }
+      result = a / b;
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool foldUnary(TT op, const Value& right, Value& result) {
+  if (op == TT::BANG) {
+    result = !right.isTruthy();
+    return true;
+  }
+  if (!right.isNumber()) {
+    return false;
+  }
+  switch (op) {
+    case TT::MINUS:
+      result = -right.asNumber();
+      return true;
+    case TT::MINUS_MINUS:
+      result = right.asNumber() - 1;
+      return true;
+    case TT::PLUS_PLUS:
+      result = right.asNumber() + 1;
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+Optimizer::Optimizer(lox::parser::Arena& arena)
+    : arena_(arena), expression_(nullptr), statement_(nullptr) {}
+
+void Optimizer::optimize(std::vector<lox::parser::Statement*>& statements) {
+  for (auto& stmt : statements) {
+    stmt = optimize(stmt);
+  }
+}
+
+lox::parser::Expression* Optimizer::optimize(lox::parser::Expression* expr) {
+  if (!expr) {
+    return nullptr;
+  }
+  expression_ = nullptr;
+  expr->accept(this);
+  auto result = expression_ ? expression_ : expr;
+  expression_ = nullptr;
+  return result;
+}
+
+lox::parser::Statement* Optimizer::optimize(lox::parser::Statement* stmt) {
+  if (!stmt) {
+    return nullptr;
+  }
+  statement_ = nullptr;
+  stmt->accept(this);
+  auto result = statement_ ? statement_ : stmt;
+  statement_ = nullptr;
+  // Copies keep the line of the statement they replace.
+  if (!result->line) {
+    result->line = stmt->line;
+  }
+  return result;
+}
+
+void Optimizer::optimize(
+    lox::parser::Span<lox::parser::Statement*> statements) {
+  for (auto& stmt : statements) {
+    stmt = optimize(stmt);
+  }
+}
+
+lox::parser::Expression* Optimizer::literal(const Value& value) {
+  return arena_.make<lox::parser::Literal>(value);
+}
+
+lox::parser::Statement* Optimizer::empty() {
+  return arena_.make<lox::parser::Block>(
+      lox::parser::Span<lox::parser::Statement*>());
+}
+
+Value Optimizer::visit(const lox::parser::Binary* expr) {
+  auto left = optimize(expr->left);
+  auto right = optimize(expr->right);
+  auto leftLiteral = asLiteral(left);
+  auto rightLiteral = asLiteral(right);
+
+  // The logical operators yield booleans. A literal left operand either
+  // decides them or leaves the truthiness of the right one.
+  if (expr->op.type == TT::AND || expr->op.type == TT::OR) {
+    bool isOr = expr->op.type == TT::OR;
+    if (leftLiteral) {
+      if (leftLiteral->value.isTruthy() == isOr) {
+        expression_ = literal(isOr);
+        return nullptr;
+      }
+      if (rightLiteral) {
+        expression_ = literal(rightLiteral->value.isTruthy());
+        return nullptr;
+      }
+    }
+  } else if (leftLiteral && rightLiteral) {
+    Value result;
+    if (foldBinary(expr->op.type, leftLiteral->value, rightLiteral->value,
+                   result)) {
+      expression_ = literal(result);
+      return nullptr;
+    }
+  }
+
+  if (left != expr->left || right != expr->right) {
+    expression_ = arena_.make<lox::parser::Binary>(left, expr->op, right);
+  }
+  return nullptr;
+}
+
+Value Optimizer::visit(const lox::parser::Grouping* expr) {
+  // Parentheses only matter to the parser.
+  expression_ = optimize(expr->expression);
+  return nullptr;
+}
+
+Value Optimizer::visit(const lox::parser::Unary* expr) {
+  auto right = optimize(expr->right);
+  auto rightLiteral = asLiteral(right);
+  Value result;
+  if (rightLiteral && foldUnary(expr->op.type, rightLiteral->value, result)) {
+    expression_ = literal(result);
+  } else if (right != expr->right) {
+    expression_ = arena_.make<lox::parser::Unary>(expr->op, right);
+  }
+  return nullptr;
+}
+
+Value Optimizer::visit(const lox::parser::Literal* expr) { return nullptr; }
+
+Value Optimizer::visit(const lox::parser::Variable* expr) { return nullptr; }
+
+Value Optimizer::visit(const lox::parser::Sequence* expr) {
+  for (auto& ex : expr->expressions) {
+    ex = optimize(ex);
+  }
+  // Conditions and operands are parsed as sequences, most of one element.
+  if (expr->expressions.size() == 1 && expr->expressions[0]) {
+    expression_ = expr->expressions[0];
+  }
+  return nullptr;
+}
+
+Value Optimizer::visit(const lox::parser::Ternary* expr) {
+  auto predicate = optimize(expr->predicate);
+  auto then = optimize(expr->then);
+  auto alternative = optimize(expr->alternative);
+  if (auto predicateLiteral = asLiteral(predicate)) {
+    if (predicateLiteral->value.isTruthy()) {
+      expression_ = then;
+    } else {
+      expression_ = alternative ? alternative : literal(nullptr);
+    }
+  } else if (predicate != expr->predicate || then != expr->then ||
+             alternative != expr->alternative) {
+    expression_ =
+        arena_.make<lox::parser::Ternary>(predicate, then, alternative);
+  }
+  return nullptr;
+}
+
+Value Optimizer::visit(const lox::parser::Assignment* expr) {
+  auto target = optimize(expr->target);
+  if (target != expr->target) {
+    auto assignment =
+        arena_.make<lox::parser::Assignment>(expr->token, target);
+    assignment->binding = expr->binding;
+    expression_ = assignment;
+  }
+  return nullptr;
+}
+
+Value Optimizer::visit(const lox::parser::Call* expr) {
+  auto callee = optimize(expr->callee);
+  // The engines take the arguments from a sequence, keep it.
+  if (auto arguments =
+          dynamic_cast<const lox::parser::Sequence*>(expr->arguments)) {
+    for (auto& arg : arguments->expressions) {
+      arg = optimize(arg);
+    }
+  }
+  if (callee != expr->callee) {
+    expression_ =
+        arena_.make<lox::parser::Call>(callee, expr->paren, expr->arguments);
+  }
+  return nullptr;
+}
+
+Value Optimizer::visit(const lox::parser::Lambda* expr) {
+  optimize(expr->function->body->statements);
+  return nullptr;
+}
+
+Value Optimizer::visit(const lox::parser::Get* expr) {
+  auto object = optimize(expr->object);
+  if (object != expr->object) {
+    expression_ = arena_.make<lox::parser::Get>(object, expr->name);
+  }
+  return nullptr;
+}
+
+Value Optimizer::visit(const lox::parser::Set* expr) {
+  auto object = optimize(expr->object);
+  auto value = optimize(expr->value);
+  if (object != expr->object || value != expr->value) {
+    expression_ = arena_.make<lox::parser::Set>(object, expr->name, value);
+  }
+  return nullptr;
+}
+
+Value Optimizer::visit(const lox::parser::This* expr) { return nullptr; }
+
+Value Optimizer::visit(const lox::parser::Super* expr) { return nullptr; }
+
+Value Optimizer::visit(const lox::parser::StatementExpression* stmt) {
+  auto expression = optimize(stmt->expression);
+  if (asLiteral(expression)) {
+    statement_ = empty();
+  } else if (expression != stmt->expression) {
+    statement_ = arena_.make<lox::parser::StatementExpression>(expression);
+  }
+  return nullptr;
+}
+
+Value Optimizer::visit(const lox::parser::Print* stmt) {
+  auto expression = optimize(stmt->expression);
+  if (expression != stmt->expression) {
+    statement_ = arena_.make<lox::parser::Print>(expression);
+  }
+  return nullptr;
+}
+
+Value Optimizer::visit(const lox::parser::Var* stmt) {
+  auto initializer = optimize(stmt->initializer);
+  if (initializer != stmt->initializer) {
+    auto var = arena_.make<lox::parser::Var>(stmt->token, initializer);
+    var->binding = stmt->binding;
+    statement_ = var;
+  }
+  return nullptr;
+}
+
+Value Optimizer::visit(const lox::parser::Block* stmt) {
+  optimize(stmt->statements);
+  return nullptr;
+}
+
+Value Optimizer::visit(const lox::parser::If* stmt) {
+  auto predicate = optimize(stmt->predicate);
+  auto then = optimize(stmt->then);
+  auto alternative = optimize(stmt->alternative);
+  if (auto predicateLiteral = asLiteral(predicate)) {
+    if (predicateLiteral->value.isTruthy()) {
+      statement_ = then;
+    } else {
+      statement_ = alternative ? alternative : empty();
+    }
+  } else if (predicate != stmt->predicate || then != stmt->then ||
+             alternative != stmt->alternative) {
+    statement_ = arena_.make<lox::parser::If>(predicate, then, alternative);
+  }
+  return nullptr;
+}
+
+Value Optimizer::visit(const lox::parser::While* stmt) {
+  auto condition = optimize(stmt->condition);
+  auto body = optimize(stmt->body);
+  if (auto conditionLiteral = asLiteral(condition)) {
+    if (!conditionLiteral->value.isTruthy()) {
+      statement_ = empty();
+      return nullptr;
+    }
+    // Loops like `for (;;)` run until they break or return.
+    condition = nullptr;
+  }
+  if (condition != stmt->condition || body != stmt->body) {
+    statement_ = arena_.make<lox::parser::While>(condition, body);
+  }
+  return nullptr;
+}
+
+Value Optimizer::visit(const lox::parser::Continue* stmt) { return nullptr; }
+
+Value Optimizer::visit(const lox::parser::Break* stmt) { return nullptr; }
+
+Value Optimizer::visit(const lox::parser::Return* stmt) {
+  auto value = optimize(stmt->value);
+  if (value != stmt->value) {
+    statement_ = arena_.make<lox::parser::Return>(stmt->token, value);
+  }
+  return nullptr;
+}
+
+Value Optimizer::visit(const lox::parser::Function* stmt) {
+  optimize(stmt->body->statements);
+  return nullptr;
+}
+
+Value Optimizer::visit(const lox::parser::Class* stmt) {
+  for (auto method : stmt->methods) {
+    optimize(method->body->statements);
+  }
+  return nullptr;
+}
+
+}  // namespace lang
+}  // namespace lox
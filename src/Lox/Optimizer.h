@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+
+#include "Arena.h"
+#include "Expression.h"
+#include "Statement.h"
+#include "Value.h"
+
+namespace lox {
+namespace lang {
+
+// Simplifies resolved programs before either engine runs them. It folds
+// operators whose operands are literals, ternaries and logical operators
+// decided by a literal operand, and branches of ifs and loops ruled out by
+// a literal condition, so constant expressions are computed once instead of
+// on every evaluation. Operations that fail at runtime, e.g. `1 / 0` or
+// `1 + nil`, are left alone to report their error when they run.
+//
+// Nodes are immutable. A node whose children change is replaced by a copy
+// allocated in the arena of the program, with the bindings the Resolver
+// filled in. Blocks and argument lists are rewritten in place.
+class Optimizer : public lox::parser::ExpressionVisitor,
+                  lox::parser::StatementVisitor {
+ public:
+  explicit Optimizer(lox::parser::Arena& arena);
+  void optimize(std::vector<lox::parser::Statement*>& statements);
+
+  Value visit(const lox::parser::Binary* expr) override;
+  Value visit(const lox::parser::Grouping* expr) override;
+  Value visit(const lox::parser::Unary* expr) override;
+  Value visit(const lox::parser::Literal* expr) override;
+  Value visit(const lox::parser::Variable* expr) override;
+  Value visit(const lox::parser::Sequence* expr) override;
+  Value visit(const lox::parser::Ternary* expr) override;
+  Value visit(const lox::parser::Assignment* expr) override;
+  Value visit(const lox::parser::Call* expr) override;
+  Value visit(const lox::parser::Lambda* expr) override;
+  Value visit(const lox::parser::Get* expr) override;
+  Value visit(const lox::parser::Set* expr) override;
+  Value visit(const lox::parser::This* expr) override;
+  Value visit(const lox::parser::Super* expr) override;
+
+  Value visit(const lox::parser::StatementExpression* stmt) override;
+  Value visit(const lox::parser::Print* stmt) override;
+  Value visit(const lox::parser::Var* stmt) override;
+  Value visit(const lox::parser::Block* stmt) override;
+  Value visit(const lox::parser::If* stmt) override;
+  Value visit(const lox::parser::While* stmt) override;
+  Value visit(const lox::parser::Continue* stmt) override;
+  Value visit(const lox::parser::Break* stmt) override;
+  Value visit(const lox::parser::Return* stmt) override;
+  Value visit(const lox::parser::Function* stmt) override;
+  Value visit(const lox::parser::Class* stmt) override;
+
+ private:
+  lox::parser::Arena& arena_;
+  // Replacements of the node being visited, nullptr keeps the node.
+  lox::parser::Expression* expression_;
+  lox::parser::Statement* statement_;
+
+  // Return the simplified form of a node, which may be the node itself.
+  lox::parser::Expression* optimize(lox::parser::Expression* expr);
+  lox::parser::Statement* optimize(lox::parser::Statement* stmt);
+  void optimize(lox::parser::Span<lox::parser::Statement*> statements);
+
+  lox::parser::Expression* literal(const Value& value);
+  lox::parser::Statement* empty();
+};
+
+}  // namespace lang
+}  // namespace lox
@@ -0,0 +1,85 @@
+#include "Profiler.h"
+
+#include <sys/time.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "Statement.h"
+
+namespace lox {
+namespace lang {
+
+std::atomic<int> Profiler::ticks_{0};
+
+Profiler::Profiler(int frequency)
+    : frequency_(std::max(frequency, 1)), running_(false), samples_(0) {}
+
+Profiler::~Profiler() { stop(); }
+
+void Profiler::start() {
+  if (running_) {
+    return;
+  }
+  ticks_.store(0);
+  struct sigaction action = {};
+  action.sa_handler = &Profiler::onTick;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGPROF, &action, &previous_);
+
+  struct itimerval timer = {};
+  timer.it_interval.tv_sec = 0;
+  timer.it_interval.tv_usec = std::max(1000000 / frequency_, 1);
+  timer.it_value = timer.it_interval;
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  running_ = true;
+}
+
+void Profiler::stop() {
+  if (!running_) {
+    return;
+  }
+  struct itimerval timer = {};
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  sigaction(SIGPROF, &previous_, nullptr);
+  ticks_.store(0);
+  running_ = false;
+}
+
+void Profiler::onTick(int signal) {
+  ticks_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Profiler::record(
+    const std::vector<const lox::parser::Function*>& stack) {
+  record(stack, ticks_.exchange(0, std::memory_order_relaxed));
+}
+
+void Profiler::record(const std::vector<const lox::parser::Function*>& stack,
+                      uint64_t ticks) {
+  if (ticks == 0) {
+    return;
+  }
+  std::string key = "<script>";
+  for (const auto* function : stack) {
+    key += ';';
+    key += function->name.lexeme;
+    key += ':';
+    key += std::to_string(function->name.line);
+  }
+  stacks_[key] += ticks;
+  samples_ += ticks;
+}
+
+void Profiler::write(std::ostream& out) const {
+  std::vector<std::pair<std::string, uint64_t>> stacks(stacks_.begin(),
+                                                       stacks_.end());
+  std::sort(stacks.begin(), stacks.end());
+  for (const auto& [stack, count] : stacks) {
+    out << stack << " " << count << "\n";
+  }
+}
+
+}  // namespace lang
+}  // namespace lox
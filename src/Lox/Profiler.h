@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lox {
+namespace parser {
+struct Function;
+}  // namespace parser
+
+namespace lang {
+
+// Sampling profiler of the Lox call stack of the tree walker.
+//
+// A SIGPROF timer ticks `frequency` times per second of CPU time. The signal
+// handler only counts the tick, the interpreter notices it at its next
+// safepoint, between two statements or loop iterations, and records its
+// stack of Lox functions with record(). Time spent in compiled code is
+// recorded once the call returns. Samples are aggregated per stack and
+// written as collapsed stacks, one "root;caller;callee count" line per
+// stack, the input of flamegraph.pl and speedscope. Frames are named
+// "function:line" after the declaration of the function, top level code
+// is "<script>".
+//
+// The timer is process wide, only one profiler runs at a time.
+class Profiler {
+ public:
+  static constexpr int kDefaultFrequency = 1000;
+
+  explicit Profiler(int frequency = kDefaultFrequency);
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+  ~Profiler();
+
+  void start();
+  void stop();
+
+  // Whether the timer ticked since the last sample.
+  static bool pending() {
+    return ticks_.load(std::memory_order_relaxed) != 0;
+  }
+
+  // Records `stack`, outermost call first, with the weight of the ticks
+  // since the last sample.
+  void record(const std::vector<const lox::parser::Function*>& stack);
+  // Records `stack` with weight `ticks`.
+  void record(const std::vector<const lox::parser::Function*>& stack,
+              uint64_t ticks);
+
+  uint64_t samples() const { return samples_; }
+  void write(std::ostream& out) const;
+
+ private:
+  static std::atomic<int> ticks_;
+  static_assert(std::atomic<int>::is_always_lock_free,
+                "The signal handler needs a lock free counter");
+
+  const int frequency_;
+  bool running_;
+  struct sigaction previous_;
+  uint64_t samples_;
+  std::unordered_map<std::string, uint64_t> stacks_;
+
+  static void onTick(int signal);
+};
+
+}  // namespace lang
+}  // namespace lox
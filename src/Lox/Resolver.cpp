@@ -1,5 +1,6 @@
 #include "Resolver.h"
 
+#include <algorithm>
 #include <string_view>
 
 #include "ParseError.h"
@@ -16,57 +17,66 @@ Resolver::Resolver(std::shared_ptr<Interpreter> interpreter)
     : interpreter_{std::move(interpreter)},
       currentFunction_(FunctionType::None),
       currentClass_(ClassType::None) {
+  functions_.push_back({nullptr, 0, 0});
   beginScope();
 };
 Resolver::~Resolver() { endScope(); }
 
-void Resolver::resolve(
-    const std::vector<std::shared_ptr<lox::parser::Statement>>& statements) {
+void Resolver::resolve(const std::vector<lox::parser::Statement*>& statements) {
   for (const auto& stmt : statements) {
     if (stmt) {
       resolve(stmt);
     }
   }
+  interpreter_->reserveSlots(functions_[0].slots);
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Variable> expr) {
+void Resolver::resolve(lox::parser::Span<lox::parser::Statement*> statements) {
+  for (const auto& stmt : statements) {
+    if (stmt) {
+      resolve(stmt);
+    }
+  }
+}
+
+Value Resolver::visit(const lox::parser::Variable* expr) {
   if (!scopes_.empty()) {
-    auto& scope = scopes_.back();
+    auto& scope = scopes_.back().locals;
     auto it = scope.find(expr->token.lexeme);
-    if (it != scope.end() && it->second == false) {
+    if (it != scope.end() && !it->second.defined) {
       lox::lang::Lox::error(expr->token, std::string(kVariableInInitializer));
     }
   }
-  resolve(expr, expr->token);
+  resolve(expr->token.lexeme, expr->binding);
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Assignment> expr) {
+Value Resolver::visit(const lox::parser::Assignment* expr) {
   resolve(expr->target);
-  resolve(expr, expr->token);
+  resolve(expr->token.lexeme, expr->binding);
   return nullptr;
 }
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Binary> expr) {
+Value Resolver::visit(const lox::parser::Binary* expr) {
   resolve(expr->left);
   resolve(expr->right);
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Grouping> expr) {
+Value Resolver::visit(const lox::parser::Grouping* expr) {
   resolve(expr->expression);
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Unary> expr) {
+Value Resolver::visit(const lox::parser::Unary* expr) {
   resolve(expr->right);
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Literal> expr) {
+Value Resolver::visit(const lox::parser::Literal* expr) {
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Call> expr) {
+Value Resolver::visit(const lox::parser::Call* expr) {
   resolve(expr->callee);
   if (expr->arguments) {
     resolve(expr->arguments);
@@ -74,7 +84,7 @@ std::any Resolver::visit(std::shared_ptr<const lox::parser::Call> expr) {
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Sequence> expr) {
+Value Resolver::visit(const lox::parser::Sequence* expr) {
   for (const auto ex : expr->expressions) {
     if (ex) {
       ex->accept(this);
@@ -83,7 +93,7 @@ std::any Resolver::visit(std::shared_ptr<const lox::parser::Sequence> expr) {
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Ternary> expr) {
+Value Resolver::visit(const lox::parser::Ternary* expr) {
   resolve(expr->predicate);
   resolve(expr->then);
   if (expr->alternative) {
@@ -92,49 +102,50 @@ std::any Resolver::visit(std::shared_ptr<const lox::parser::Ternary> expr) {
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Lambda> expr) {
+Value Resolver::visit(const lox::parser::Lambda* expr) {
   resolve(expr->function, FunctionType::Function);
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Get> expr) {
+Value Resolver::visit(const lox::parser::Get* expr) {
   resolve(expr->object);
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Set> expr) {
+Value Resolver::visit(const lox::parser::Set* expr) {
   resolve(expr->object);
   resolve(expr->value);
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::This> expr) {
-  if (currentClass_ != ClassType::Class) {
+Value Resolver::visit(const lox::parser::This* expr) {
+  if (currentClass_ == ClassType::None) {
     lox::lang::Lox::error(expr->token, "This not inside class method.");
   }
-  resolve(expr, expr->token);
+  resolve(expr->token.lexeme, expr->binding);
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Super> expr) {
+Value Resolver::visit(const lox::parser::Super* expr) {
   if (currentClass_ == ClassType::None) {
     lox::lang::Lox::error(expr->keyword, "Super not inside class method.");
   } else if (currentClass_ != ClassType::Subclass) {
     lox::lang::Lox::error(expr->keyword, "Super must be inside subclass.");
   }
-  resolve(expr, expr->keyword);
+  resolve(expr->keyword.lexeme, expr->binding);
+  resolve("this", expr->receiver);
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Block> stmt) {
+Value Resolver::visit(const lox::parser::Block* stmt) {
   beginScope();
   resolve(stmt->statements);
   endScope();
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Var> stmt) {
-  declare(stmt->token);
+Value Resolver::visit(const lox::parser::Var* stmt) {
+  declare(stmt->token, &stmt->binding);
   if (stmt->initializer) {
     resolve(stmt->initializer);
   }
@@ -142,18 +153,18 @@ std::any Resolver::visit(std::shared_ptr<const lox::parser::Var> stmt) {
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Function> stmt) {
-  declare(stmt->name);
+Value Resolver::visit(const lox::parser::Function* stmt) {
+  declare(stmt->name, &stmt->binding);
   define(stmt->name);
   resolve(stmt, FunctionType::Function);
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Class> stmt) {
+Value Resolver::visit(const lox::parser::Class* stmt) {
   ClassType enclosing = currentClass_;
   currentClass_ = ClassType::Class;
 
-  declare(stmt->name);
+  declare(stmt->name, &stmt->binding);
   define(stmt->name);
 
   if (stmt->superclass) {
@@ -164,19 +175,15 @@ std::any Resolver::visit(std::shared_ptr<const lox::parser::Class> stmt) {
     resolve(stmt->superclass);
 
     beginScope();
-    scopes_.back().insert({"super", true});
+    addLocal("super", &stmt->superBinding, false);
   }
 
-  beginScope();
-  scopes_.back().insert({"this", true});
-
   for (const auto& s : stmt->methods) {
     FunctionType methodType = s->name.lexeme == "init"
                                   ? FunctionType::Initializer
                                   : FunctionType::Method;
     resolve(s, methodType);
   }
-  endScope();
   if (stmt->superclass) {
     endScope();
   }
@@ -184,26 +191,25 @@ std::any Resolver::visit(std::shared_ptr<const lox::parser::Class> stmt) {
   return nullptr;
 }
 
-std::any Resolver::visit(
-    std::shared_ptr<const lox::parser::StatementExpression> stmt) {
+Value Resolver::visit(const lox::parser::StatementExpression* stmt) {
   resolve(stmt->expression);
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Print> stmt) {
+Value Resolver::visit(const lox::parser::Print* stmt) {
   resolve(stmt->expression);
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Continue> stmt) {
+Value Resolver::visit(const lox::parser::Continue* stmt) {
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Break> stmt) {
+Value Resolver::visit(const lox::parser::Break* stmt) {
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::If> stmt) {
+Value Resolver::visit(const lox::parser::If* stmt) {
   resolve(stmt->predicate);
   resolve(stmt->then);
   if (stmt->alternative) {
@@ -212,13 +218,15 @@ std::any Resolver::visit(std::shared_ptr<const lox::parser::If> stmt) {
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::While> stmt) {
-  resolve(stmt->condition);
+Value Resolver::visit(const lox::parser::While* stmt) {
+  if (stmt->condition) {
+    resolve(stmt->condition);
+  }
   resolve(stmt->body);
   return nullptr;
 }
 
-std::any Resolver::visit(std::shared_ptr<const lox::parser::Return> stmt) {
+Value Resolver::visit(const lox::parser::Return* stmt) {
   if (currentFunction_ == FunctionType::None) {
     lox::lang::Lox::error(stmt->token, "Return not inside function.");
   }
@@ -231,63 +239,154 @@ std::any Resolver::visit(std::shared_ptr<const lox::parser::Return> stmt) {
   return nullptr;
 }
 
-void Resolver::resolve(const std::shared_ptr<lox::parser::Statement>& stmt) {
+void Resolver::resolve(const lox::parser::Statement* stmt) {
   stmt->accept(this);
 }
 
-void Resolver::resolve(const std::shared_ptr<lox::parser::Expression>& expr) {
+void Resolver::resolve(const lox::parser::Expression* expr) {
   expr->accept(this);
 }
 
-void Resolver::resolve(std::shared_ptr<const lox::parser::Expression> expr,
-                       const lox::parser::Token& name) {
+void Resolver::resolve(std::string_view name, lox::parser::Binding& binding) {
+  using Kind = lox::parser::Binding::Kind;
+  // scopes_[0] is the global scope, globals are looked up by slot in the
+  // interpreter's global table instead.
+  int current = functions_.size() - 1;
   for (int i = scopes_.size() - 1; i >= 1; i--) {
-    auto& scope = scopes_.at(i);
-    auto it = scope.find(name.lexeme);
-    if (it != scope.end()) {
-      interpreter_->resolve(expr, scopes_.size() - 2 - i);
+    auto& scope = scopes_[i];
+    auto it = scope.locals.find(name);
+    if (it == scope.locals.end()) {
+      continue;
+    }
+    auto& local = it->second;
+    if (scope.function == current) {
+      binding.kind = Kind::Local;
+      binding.index = local.slot;
+      local.uses.push_back(&binding);
       return;
     }
+    // A variable of an enclosing function: every function in between passes
+    // it on as an upvalue.
+    local.captured = true;
+    bool isLocal = true;
+    int index = local.slot;
+    for (int function = scope.function + 1; function <= current; function++) {
+      index = addUpvalue(function, isLocal, index);
+      isLocal = false;
+    }
+    binding.kind = Kind::Upvalue;
+    binding.index = index;
+    return;
+  }
+  binding.kind = Kind::Global;
+  binding.index = interpreter_->globalSlot(name);
+}
+
+int Resolver::addUpvalue(int function, bool isLocal, int index) {
+  auto& captures = functions_[function].declaration->captures;
+  for (int i = 0; i < captures.size(); i++) {
+    if (captures[i].isLocal == isLocal && captures[i].index == index) {
+      return i;
+    }
   }
+  captures.push_back({isLocal, index});
+  return captures.size() - 1;
 }
 
-void Resolver::resolve(std::shared_ptr<const lox::parser::Function> func,
+void Resolver::resolve(const lox::parser::Function* func,
                        FunctionType type) {
   FunctionType enclosing = currentFunction_;
   currentFunction_ = type;
+  // The first slot of a frame holds the callee, the parameters follow it.
+  // Methods find their receiver, "this", there instead.
+  bool method =
+      type == FunctionType::Method || type == FunctionType::Initializer;
+  functions_.push_back({func, method ? 0 : 1, 1});
   beginScope();
+  if (method) {
+    addLocal("this", nullptr, true);
+  }
   for (const auto& param : func->parameters) {
-    declare(param);
+    declare(param, nullptr, true);
     define(param);
   }
-  resolve(func->body);
+  // The body shares the scope of the parameters, as it does at runtime.
+  resolve(func->body->statements);
   endScope();
+  func->slots = functions_.back().slots;
+  functions_.pop_back();
   currentFunction_ = enclosing;
 }
 
 void Resolver::beginScope() {
-  scopes_.push_back(std::unordered_map<std::string, bool>{});
+  int function = functions_.size() - 1;
+  scopes_.push_back({{}, function, functions_[function].nextSlot});
 }
 
-void Resolver::endScope() { scopes_.pop_back(); }
+void Resolver::endScope() {
+  auto& scope = scopes_.back();
+  auto& function = functions_[scope.function];
+  for (auto& [name, local] : scope.locals) {
+    if (!local.captured) {
+      continue;
+    }
+    for (auto binding : local.uses) {
+      binding->kind = lox::parser::Binding::Kind::Cell;
+    }
+    if (local.parameter) {
+      function.declaration->boxedParameters.push_back(local.slot);
+    }
+  }
+  function.nextSlot = scope.firstSlot;
+  scopes_.pop_back();
+}
 
-void Resolver::declare(const lox::parser::Token& name) {
+void Resolver::declare(const lox::parser::Token& name,
+                       lox::parser::Binding* binding, bool parameter) {
   if (scopes_.empty()) {
     return;
   }
-  auto& scope = scopes_.back();
+  auto& scope = scopes_.back().locals;
   if (scope.find(name.lexeme) != scope.end()) {
     lox::lang::Lox::error(name, std::string(kVariableDefined));
+    return;
   }
-  scope.insert({name.lexeme, false});
+  addLocal(name.lexeme, binding, parameter);
+}
+
+void Resolver::addLocal(std::string_view name, lox::parser::Binding* binding,
+                        bool parameter) {
+  using Kind = lox::parser::Binding::Kind;
+  auto& scope = scopes_.back();
+  if (scopes_.size() == 1) {
+    scope.locals.insert({name, Local{false, 0, false, false, {}}});
+    if (binding) {
+      binding->kind = Kind::Global;
+      binding->index = interpreter_->globalSlot(name);
+    }
+    return;
+  }
+
+  auto& function = functions_[scope.function];
+  Local local{false, function.nextSlot++, parameter, false, {}};
+  function.slots = std::max(function.slots, function.nextSlot);
+  if (binding) {
+    binding->kind = Kind::Local;
+    binding->index = local.slot;
+    local.uses.push_back(binding);
+  }
+  scope.locals.insert({name, std::move(local)});
 }
 
 void Resolver::define(const lox::parser::Token& name) {
   if (scopes_.empty()) {
     return;
   }
-  auto& scope = scopes_.back();
-  scope.insert_or_assign(name.lexeme, true);
+  auto& scope = scopes_.back().locals;
+  auto it = scope.find(name.lexeme);
+  if (it != scope.end()) {
+    it->second.defined = true;
+  }
 }
 }  // namespace lang
 }  // namespace lox
\ No newline at end of file
@@ -1,7 +1,7 @@
 #pragma once
-#include <any>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -17,55 +17,89 @@ class Resolver : public lox::parser::ExpressionVisitor,
  public:
   Resolver(std::shared_ptr<Interpreter> interpreter);
   ~Resolver();
-  void resolve(
-      const std::vector<std::shared_ptr<lox::parser::Statement>>& statements);
+  void resolve(const std::vector<lox::parser::Statement*>& statements);
 
-  std::any visit(std::shared_ptr<const lox::parser::Binary> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Grouping> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Unary> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Literal> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Variable> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Sequence> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Ternary> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Assignment> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Call> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Lambda> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Get> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Set> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::This> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Super> expr) override;
+  Value visit(const lox::parser::Binary* expr) override;
+  Value visit(const lox::parser::Grouping* expr) override;
+  Value visit(const lox::parser::Unary* expr) override;
+  Value visit(const lox::parser::Literal* expr) override;
+  Value visit(const lox::parser::Variable* expr) override;
+  Value visit(const lox::parser::Sequence* expr) override;
+  Value visit(const lox::parser::Ternary* expr) override;
+  Value visit(const lox::parser::Assignment* expr) override;
+  Value visit(const lox::parser::Call* expr) override;
+  Value visit(const lox::parser::Lambda* expr) override;
+  Value visit(const lox::parser::Get* expr) override;
+  Value visit(const lox::parser::Set* expr) override;
+  Value visit(const lox::parser::This* expr) override;
+  Value visit(const lox::parser::Super* expr) override;
 
-  std::any visit(
-      std::shared_ptr<const lox::parser::StatementExpression> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::Print> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::Var> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::Block> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::If> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::While> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::Continue> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::Break> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::Return> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::Function> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::Class> stmt) override;
+  Value visit(const lox::parser::StatementExpression* stmt) override;
+  Value visit(const lox::parser::Print* stmt) override;
+  Value visit(const lox::parser::Var* stmt) override;
+  Value visit(const lox::parser::Block* stmt) override;
+  Value visit(const lox::parser::If* stmt) override;
+  Value visit(const lox::parser::While* stmt) override;
+  Value visit(const lox::parser::Continue* stmt) override;
+  Value visit(const lox::parser::Break* stmt) override;
+  Value visit(const lox::parser::Return* stmt) override;
+  Value visit(const lox::parser::Function* stmt) override;
+  Value visit(const lox::parser::Class* stmt) override;
 
  private:
   enum class FunctionType { None, Function, Method, Initializer };
   enum class ClassType { None, Class, Subclass };
 
+  // A variable declared in a local scope. It gets a slot in the frame of
+  // its function; slots of a scope are reused once the scope ends.
+  struct Local {
+    bool defined;
+    int slot;
+    bool parameter;
+    // Set once a closure refers to the variable, which then lives in a Cell.
+    bool captured;
+    // References from the declaring function, turned into Cell bindings
+    // when the scope ends if the variable got captured.
+    std::vector<lox::parser::Binding*> uses;
+  };
+
+  struct Scope {
+    std::unordered_map<std::string_view, Local> locals;
+    // Index of the function owning the scope in functions_.
+    int function;
+    int firstSlot;
+  };
+
+  // A function being resolved, functions_[0] stands for top level code.
+  struct FunctionState {
+    const lox::parser::Function* declaration;
+    int nextSlot;
+    int slots;
+  };
+
   const std::shared_ptr<Interpreter> interpreter_;
   FunctionType currentFunction_;
   ClassType currentClass_;
-  std::vector<std::unordered_map<std::string, bool>> scopes_;
+  // scopes_[0] is the global scope.
+  std::vector<Scope> scopes_;
+  std::vector<FunctionState> functions_;
 
-  void resolve(const std::shared_ptr<lox::parser::Statement>& stmt);
-  void resolve(const std::shared_ptr<lox::parser::Expression>& expr);
-  void resolve(std::shared_ptr<const lox::parser::Expression> expr,
-               const lox::parser::Token& name);
-  void resolve(std::shared_ptr<const lox::parser::Function> func,
+  void resolve(lox::parser::Span<lox::parser::Statement*> statements);
+  void resolve(const lox::parser::Statement* stmt);
+  void resolve(const lox::parser::Expression* expr);
+  void resolve(std::string_view name, lox::parser::Binding& binding);
+  void resolve(const lox::parser::Function* func,
                FunctionType type);
+  int addUpvalue(int function, bool isLocal, int index);
   void beginScope();
   void endScope();
-  void declare(const lox::parser::Token& name);
+  // Declares `name` in the innermost scope and fills in `binding`, if given,
+  // with where the variable lives.
+  void declare(const lox::parser::Token& name,
+               lox::parser::Binding* binding = nullptr,
+               bool parameter = false);
+  void addLocal(std::string_view name, lox::parser::Binding* binding,
+                bool parameter);
   void define(const lox::parser::Token& name);
 };
 
@@ -0,0 +1,80 @@
+#pragma once
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace lox {
+namespace lang {
+
+// Hidden class describing the field layout of instances: which names they
+// have and the slot each one is stored in. Instances gaining the same fields
+// in the same order share one Shape, so an instance only stores the field
+// values and a pointer to its shape.
+//
+// Shapes form a tree rooted at the empty shape, adding a field moves an
+// instance to a child. Shapes are never freed, their number is bounded by
+// the distinct field layouts a program creates.
+class Shape {
+ public:
+  Shape(const Shape&) = delete;
+  Shape& operator=(const Shape&) = delete;
+
+  // Shape of instances without fields. Never destroyed.
+  static Shape* empty() {
+    static auto* root = new Shape(nullptr, {});
+    return root;
+  }
+
+  // Slot of the field `name`, -1 if instances of this shape do not have it.
+  int lookup(std::string_view name) const {
+    if (names_.size() > kLinearLookup) {
+      auto it = slots_.find(name);
+      return it != slots_.end() ? it->second : -1;
+    }
+    // Names are interned, a pointer comparison settles most probes.
+    for (size_t i = 0; i < names_.size(); i++) {
+      if (names_[i].data() == name.data() || names_[i] == name) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  // Shape of an instance of this shape after adding the field `name`, which
+  // gets the next free slot.
+  Shape* withField(std::string_view name) {
+    auto it = transitions_.find(name);
+    if (it != transitions_.end()) {
+      return it->second.get();
+    }
+    auto child = std::unique_ptr<Shape>(new Shape(this, name));
+    return transitions_.emplace(name, std::move(child)).first->second.get();
+  }
+
+  size_t size() const { return names_.size(); }
+  std::string_view name(int slot) const { return names_[slot]; }
+
+ private:
+  // Shapes with more fields than this index their names in a hash map.
+  static constexpr size_t kLinearLookup = 8;
+
+  Shape(const Shape* parent, std::string_view name) {
+    if (parent) {
+      names_ = parent->names_;
+      names_.push_back(name);
+      if (names_.size() > kLinearLookup) {
+        for (size_t i = 0; i < names_.size(); i++) {
+          slots_.emplace(names_[i], i);
+        }
+      }
+    }
+  }
+
+  std::vector<std::string_view> names_;
+  std::unordered_map<std::string_view, int> slots_;
+  std::unordered_map<std::string_view, std::unique_ptr<Shape>> transitions_;
+};
+
+}  // namespace lang
+}  // namespace lox
@@ -0,0 +1,42 @@
+#pragma once
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace lox {
+namespace parser {
+
+// Interned identifier names. Every distinct name is stored once and stays
+// alive for the rest of the process, so the views handed out remain valid
+// after the source they were scanned from is released, and equal names
+// share the same characters.
+class SymbolTable {
+ public:
+  std::string_view intern(std::string_view name) {
+    auto it = symbols_.find(name);
+    if (it != symbols_.end()) {
+      return *it;
+    }
+    const std::string& stored = storage_.emplace_back(name);
+    symbols_.insert(stored);
+    return stored;
+  }
+
+  size_t size() const { return symbols_.size(); }
+
+ private:
+  // std::deque never relocates its elements, views into them stay valid.
+  std::deque<std::string> storage_;
+  std::unordered_set<std::string_view> symbols_;
+};
+
+// Table shared by every scanner. Never destroyed, so names stay valid during
+// static destruction as well.
+inline SymbolTable& symbols() {
+  static auto* table = new SymbolTable();
+  return *table;
+}
+
+}  // namespace parser
+}  // namespace lox
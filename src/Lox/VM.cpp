@@ -0,0 +1,573 @@
+#include "VM.h"
+
+#include <chrono>
+#include <iostream>
+
+#include "Compiler.h"
+#include "Heap.h"
+#include "LoxString.h"
+#include "lox.h"
+#include "utils.h"
+
+namespace lox {
+namespace vm {
+
+namespace {
+
+Value clockNative(int argCount, Value* args) {
+  return std::chrono::duration<double>(
+             std::chrono::duration_cast<std::chrono::milliseconds>(
+                 std::chrono::system_clock::now().time_since_epoch()))
+      .count();
+}
+
+}  // namespace
+
+VM::VM()
+    : stack_(kStackMax),
+      stackTop_(stack_.data()),
+      frameCount_(0),
+      openUpvalues_(nullptr) {
+  defineNative("clock", 0, clockNative);
+  lox::lang::heap().addRoots(this);
+}
+
+VM::~VM() { lox::lang::heap().removeRoots(this); }
+
+void VM::markRoots(Heap& heap) {
+  for (Value* slot = stack_.data(); slot < stackTop_; slot++) {
+    heap.mark(*slot);
+  }
+  for (int i = 0; i < frameCount_; i++) {
+    heap.mark(frames_[i].closure);
+  }
+  for (Upvalue* upvalue = openUpvalues_; upvalue; upvalue = upvalue->next) {
+    heap.mark(upvalue);
+  }
+  for (const auto& global : globals_) {
+    heap.mark(global);
+  }
+}
+
+void VM::interpret(const std::vector<lox::parser::Statement*>& statements) {
+  for (const auto& stmt : statements) {
+    if (!stmt) {
+      continue;
+    }
+    lox::lang::heap().safepoint();
+    auto function = Compiler(*this).compileScript(stmt);
+    if (!function) {
+      continue;
+    }
+    auto closure = lox::lang::makeObject<Closure>(function);
+    push(closure);
+    try {
+      call(closure, 0);
+      run();
+    } catch (lox::lang::RuntimeError& error) {
+      lox::lang::Lox::runtime_error(error);
+      resetStack();
+    }
+  }
+}
+
+int VM::globalSlot(const std::string& name) {
+  auto it = globalSlots_.find(name);
+  if (it != globalSlots_.end()) {
+    return it->second;
+  }
+  int slot = globals_.size();
+  globalSlots_.insert({name, slot});
+  globalNames_.push_back(name);
+  globals_.emplace_back(nullptr);
+  globalDefined_.push_back(false);
+  return slot;
+}
+
+void VM::run() {
+  CallFrame* frame = &frames_[frameCount_ - 1];
+  const uint8_t* ip = frame->ip;
+
+  auto readByte = [&]() { return *ip++; };
+  auto readShort = [&]() {
+    ip += 2;
+    return static_cast<uint16_t>((ip[-2] << 8) | ip[-1]);
+  };
+  auto readConstant = [&]() -> const Value& {
+    return frame->closure->function->chunk.constants[readShort()];
+  };
+  auto readName = [&]() -> const std::string& {
+    return readConstant().as<lox::lang::LoxString>()->value();
+  };
+  // Saves the instruction pointer so that errors report the right line and
+  // calls know where to return to.
+  auto sync = [&]() { frame->ip = ip; };
+  auto reload = [&]() {
+    frame = &frames_[frameCount_ - 1];
+    ip = frame->ip;
+  };
+  auto checkNumbers = [&]() {
+    if (!peek(0).isNumber() || !peek(1).isNumber()) {
+      sync();
+      throw error("Operands must be numbers.");
+    }
+  };
+
+  for (;;) {
+    switch (static_cast<OpCode>(readByte())) {
+      case OpCode::CONSTANT:
+        push(readConstant());
+        break;
+      case OpCode::NIL:
+        push(nullptr);
+        break;
+      case OpCode::TRUE:
+        push(true);
+        break;
+      case OpCode::FALSE:
+        push(false);
+        break;
+      case OpCode::POP:
+        pop();
+        break;
+      case OpCode::GET_LOCAL:
+        push(frame->slots[readByte()]);
+        break;
+      case OpCode::SET_LOCAL:
+        frame->slots[readByte()] = peek(0);
+        break;
+      case OpCode::GET_GLOBAL: {
+        uint16_t slot = readShort();
+        if (!globalDefined_[slot]) {
+          sync();
+          throw error("Undefined variable '" + globalNames_[slot] + "'.");
+        }
+        push(globals_[slot]);
+        break;
+      }
+      case OpCode::DEFINE_GLOBAL: {
+        uint16_t slot = readShort();
+        globals_[slot] = pop();
+        globalDefined_[slot] = true;
+        break;
+      }
+      case OpCode::SET_GLOBAL: {
+        uint16_t slot = readShort();
+        if (!globalDefined_[slot]) {
+          sync();
+          throw error("Assinment to unbound variable '" + globalNames_[slot] +
+                      "'.");
+        }
+        globals_[slot] = peek(0);
+        break;
+      }
+      case OpCode::GET_UPVALUE:
+        push(*frame->closure->upvalues[readByte()]->location);
+        break;
+      case OpCode::SET_UPVALUE:
+        *frame->closure->upvalues[readByte()]->location = peek(0);
+        break;
+      case OpCode::GET_PROPERTY: {
+        const std::string& name = readName();
+        if (!peek(0).isObject(ObjectType::VmInstance)) {
+          sync();
+          throw error("Only instances have properties.");
+        }
+        auto instance = peek(0).as<Instance>();
+        auto it = instance->fields.find(name);
+        if (it != instance->fields.end()) {
+          Value value = it->second;
+          pop();
+          push(value);
+          break;
+        }
+        if (!bindMethod(instance->klass, name)) {
+          sync();
+          throw error("Undefined property");
+        }
+        break;
+      }
+      case OpCode::SET_PROPERTY: {
+        const std::string& name = readName();
+        if (!peek(1).isObject(ObjectType::VmInstance)) {
+          sync();
+          throw error("Only instances have properties.");
+        }
+        peek(1).as<Instance>()->fields[name] = peek(0);
+        Value value = pop();
+        pop();
+        push(value);
+        break;
+      }
+      case OpCode::GET_SUPER: {
+        const std::string& name = readName();
+        Value superclass = pop();
+        if (!bindMethod(superclass.as<Class>(), name)) {
+          sync();
+          throw error("Undefined method.");
+        }
+        break;
+      }
+      case OpCode::EQUAL: {
+        Value b = pop();
+        Value a = pop();
+        push(a.equals(b));
+        break;
+      }
+      case OpCode::GREATER: {
+        checkNumbers();
+        double b = pop().asNumber();
+        double a = pop().asNumber();
+        push(a > b);
+        break;
+      }
+      case OpCode::GREATER_EQUAL: {
+        checkNumbers();
+        double b = pop().asNumber();
+        double a = pop().asNumber();
+        push(a >= b);
+        break;
+      }
+      case OpCode::LESS: {
+        checkNumbers();
+        double b = pop().asNumber();
+        double a = pop().asNumber();
+        push(a < b);
+        break;
+      }
+      case OpCode::LESS_EQUAL: {
+        checkNumbers();
+        double b = pop().asNumber();
+        double a = pop().asNumber();
+        push(a <= b);
+        break;
+      }
+      case OpCode::ADD: {
+        if (peek(0).isNumber() && peek(1).isNumber()) {
+          double b = pop().asNumber();
+          double a = pop().asNumber();
+          push(a + b);
+        } else if (peek(0).isString() || peek(1).isString()) {
+          Value b = pop();
+          Value a = pop();
+          push(lox::lang::concatenate(a, b));
+        } else {
+          sync();
+          throw error("Operands must be either numbers or strings.");
+        }
+        break;
+      }
+      case OpCode::SUBTRACT: {
+        checkNumbers();
+        double b = pop().asNumber();
+        double a = pop().asNumber();
+        push(a - b);
+        break;
+      }
+      case OpCode::MULTIPLY: {
+        checkNumbers();
+        double b = pop().asNumber();
+        double a = pop().asNumber();
+        push(a * b);
+        break;
+      }
+      case OpCode::DIVIDE: {
+        checkNumbers();
+        if (peek(0).asNumber() == 0) {
+          sync();
+          throw error("Second operand must be non-zero.");
+        }
+        double b = pop().asNumber();
+        double a = pop().asNumber();
+        push(a / b);
+        break;
+      }
+      case OpCode::NOT:
+        push(!pop().isTruthy());
+        break;
+      case OpCode::NEGATE:
+        if (!peek(0).isNumber()) {
+          sync();
+          throw error("Operand must be number.");
+        }
+        push(-pop().asNumber());
+        break;
+      case OpCode::INCREMENT:
+        if (!peek(0).isNumber()) {
+          sync();
+          throw error("Operand must be number.");
+        }
+        push(pop().asNumber() + 1);
+        break;
+      case OpCode::DECREMENT:
+        if (!peek(0).isNumber()) {
+          sync();
+          throw error("Operand must be number.");
+        }
+        push(pop().asNumber() - 1);
+        break;
+      case OpCode::TRUTHY:
+        push(pop().isTruthy());
+        break;
+      case OpCode::PRINT:
+        std::cout << "[Out]: " << lox::util::to_string(pop()) << "\n";
+        break;
+      case OpCode::JUMP: {
+        uint16_t offset = readShort();
+        ip += offset;
+        break;
+      }
+      case OpCode::JUMP_IF_FALSE: {
+        uint16_t offset = readShort();
+        if (!peek(0).isTruthy()) {
+          ip += offset;
+        }
+        break;
+      }
+      case OpCode::LOOP: {
+        uint16_t offset = readShort();
+        ip -= offset;
+        lox::lang::heap().safepoint();
+        break;
+      }
+      case OpCode::CALL: {
+        int argCount = readByte();
+        lox::lang::heap().safepoint();
+        sync();
+        callValue(peek(argCount), argCount);
+        reload();
+        break;
+      }
+      case OpCode::INVOKE: {
+        const std::string& name = readName();
+        int argCount = readByte();
+        lox::lang::heap().safepoint();
+        sync();
+        invoke(name, argCount);
+        reload();
+        break;
+      }
+      case OpCode::SUPER_INVOKE: {
+        const std::string& name = readName();
+        int argCount = readByte();
+        lox::lang::heap().safepoint();
+        Value superclass = pop();
+        auto it = superclass.as<Class>()->methods.find(name);
+        sync();
+        if (it == superclass.as<Class>()->methods.end()) {
+          throw error("Undefined method.");
+        }
+        call(it->second.as<Closure>(), argCount);
+        reload();
+        break;
+      }
+      case OpCode::CLOSURE: {
+        auto function = readConstant().as<Function>();
+        auto closure = lox::lang::makeObject<Closure>(function);
+        for (auto& upvalue : closure->upvalues) {
+          uint8_t isLocal = readByte();
+          uint8_t index = readByte();
+          upvalue = isLocal ? captureUpvalue(frame->slots + index)
+                            : frame->closure->upvalues[index];
+        }
+        push(closure);
+        break;
+      }
+      case OpCode::CLOSE_UPVALUE:
+        closeUpvalues(stackTop_ - 1);
+        pop();
+        break;
+      case OpCode::RETURN: {
+        Value result = pop();
+        closeUpvalues(frame->slots);
+        frameCount_--;
+        while (stackTop_ > frame->slots) {
+          pop();
+        }
+        if (frameCount_ == 0) {
+          return;
+        }
+        push(result);
+        reload();
+        break;
+      }
+      case OpCode::CLASS:
+        push(lox::lang::makeObject<Class>(readName()));
+        break;
+      case OpCode::INHERIT: {
+        if (!peek(1).isObject(ObjectType::VmClass)) {
+          sync();
+          throw error("Superclass mast be a class.");
+        }
+        auto superclass = peek(1).as<Class>();
+        auto subclass = peek(0).as<Class>();
+        subclass->methods = superclass->methods;
+        subclass->initializer = superclass->initializer;
+        pop();
+        break;
+      }
+      case OpCode::METHOD: {
+        const std::string& name = readName();
+        auto klass = peek(1).as<Class>();
+        klass->methods[name] = peek(0);
+        if (name == "init") {
+          klass->initializer = peek(0);
+        }
+        pop();
+        break;
+      }
+    }
+  }
+}
+
+void VM::resetStack() {
+  closeUpvalues(stack_.data());
+  while (stackTop_ > stack_.data()) {
+    pop();
+  }
+  frameCount_ = 0;
+}
+
+void VM::callValue(Value callee, int argCount) {
+  if (callee.isObject()) {
+    switch (callee.asObject()->type()) {
+      case ObjectType::VmClosure:
+        call(callee.as<Closure>(), argCount);
+        return;
+      case ObjectType::VmBoundMethod: {
+        auto bound = callee.as<BoundMethod>();
+        stackTop_[-argCount - 1] = bound->receiver;
+        call(bound->method, argCount);
+        return;
+      }
+      case ObjectType::VmClass: {
+        auto klass = callee.as<Class>();
+        stackTop_[-argCount - 1] = lox::lang::makeObject<Instance>(klass);
+        if (!klass->initializer.isNil()) {
+          call(klass->initializer.as<Closure>(), argCount);
+        } else {
+          checkArity(0, argCount);
+        }
+        return;
+      }
+      case ObjectType::VmNative: {
+        auto native = callee.as<Native>();
+        checkArity(native->arity, argCount);
+        Value result = native->function(argCount, stackTop_ - argCount);
+        for (int i = 0; i <= argCount; i++) {
+          pop();
+        }
+        push(result);
+        return;
+      }
+      default:
+        break;
+    }
+  }
+  throw error("Can only call functions and classes.");
+}
+
+void VM::call(Closure* closure, int argCount) {
+  checkArity(closure->function->arity, argCount);
+  if (frameCount_ == kFramesMax) {
+    throw error("Stack overflow.");
+  }
+  CallFrame* frame = &frames_[frameCount_++];
+  frame->closure = closure;
+  frame->ip = closure->function->chunk.code.data();
+  frame->slots = stackTop_ - argCount - 1;
+}
+
+void VM::invoke(const std::string& name, int argCount) {
+  Value receiver = peek(argCount);
+  if (!receiver.isObject(ObjectType::VmInstance)) {
+    throw error("Only instances have properties.");
+  }
+  auto instance = receiver.as<Instance>();
+  auto it = instance->fields.find(name);
+  if (it != instance->fields.end()) {
+    Value field = it->second;
+    stackTop_[-argCount - 1] = field;
+    callValue(field, argCount);
+    return;
+  }
+  invokeFromClass(instance->klass, name, argCount);
+}
+
+void VM::invokeFromClass(Class* klass, const std::string& name,
+                         int argCount) {
+  auto it = klass->methods.find(name);
+  if (it == klass->methods.end()) {
+    throw error("Undefined property");
+  }
+  call(it->second.as<Closure>(), argCount);
+}
+
+bool VM::bindMethod(Class* klass, const std::string& name) {
+  auto it = klass->methods.find(name);
+  if (it == klass->methods.end()) {
+    return false;
+  }
+  auto bound =
+      lox::lang::makeObject<BoundMethod>(peek(0), it->second.as<Closure>());
+  pop();
+  push(bound);
+  return true;
+}
+
+void VM::checkArity(int arity, int argCount) {
+  if (arity != argCount) {
+    throw error("Invalid argument number: arg number = " +
+                std::to_string(argCount) +
+                " function arity = " + std::to_string(arity));
+  }
+}
+
+Upvalue* VM::captureUpvalue(Value* local) {
+  Upvalue* prev = nullptr;
+  Upvalue* upvalue = openUpvalues_;
+  while (upvalue && upvalue->location > local) {
+    prev = upvalue;
+    upvalue = upvalue->next;
+  }
+  if (upvalue && upvalue->location == local) {
+    return upvalue;
+  }
+
+  auto created = lox::lang::makeObject<Upvalue>(local);
+  created->next = upvalue;
+  if (prev) {
+    prev->next = created;
+  } else {
+    openUpvalues_ = created;
+  }
+  return created;
+}
+
+void VM::closeUpvalues(Value* last) {
+  while (openUpvalues_ && openUpvalues_->location >= last) {
+    Upvalue* upvalue = openUpvalues_;
+    upvalue->closed = *upvalue->location;
+    upvalue->location = &upvalue->closed;
+    openUpvalues_ = upvalue->next;
+    upvalue->next = nullptr;
+  }
+}
+
+void VM::defineNative(const std::string& name, int arity, NativeFn function) {
+  int slot = globalSlot(name);
+  globals_[slot] = lox::lang::makeObject<Native>(name, arity, function);
+  globalDefined_[slot] = true;
+}
+
+lox::lang::RuntimeError VM::error(const std::string& message) const {
+  const CallFrame& frame = frames_[frameCount_ - 1];
+  const Chunk& chunk = frame.closure->function->chunk;
+  int line = chunk.lines[frame.ip - chunk.code.data() - 1];
+  return lox::lang::RuntimeError(
+      lox::parser::Token(lox::parser::Token::TokenType::IDENTIFIER, "", line),
+      message);
+}
+
+}  // namespace vm
+}  // namespace lox
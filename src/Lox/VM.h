@@ -0,0 +1,74 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Chunk.h"
+#include "Heap.h"
+#include "RuntimeError.h"
+#include "Statement.h"
+#include "Value.h"
+#include "VmObjects.h"
+
+namespace lox {
+namespace vm {
+
+constexpr int kFramesMax = 256;
+constexpr int kStackMax = kFramesMax * 256;
+
+// Stack based virtual machine executing the bytecode produced by Compiler.
+// Globals live in a flat table, the compiler resolves every global name to a
+// slot index once so the VM never hashes names for variable access.
+class VM : public lox::lang::RootSource {
+ public:
+  VM();
+  ~VM();
+
+  void interpret(const std::vector<lox::parser::Statement*>& statements);
+
+  int globalSlot(const std::string& name);
+
+  // RootSource
+  void markRoots(Heap& heap) override;
+
+ private:
+  struct CallFrame {
+    Closure* closure;
+    const uint8_t* ip;
+    Value* slots;
+  };
+
+  std::vector<Value> stack_;
+  Value* stackTop_;
+  CallFrame frames_[kFramesMax];
+  int frameCount_;
+  Upvalue* openUpvalues_;
+
+  std::unordered_map<std::string, int> globalSlots_;
+  std::vector<std::string> globalNames_;
+  std::vector<Value> globals_;
+  std::vector<bool> globalDefined_;
+
+  void run();
+  void resetStack();
+
+  void push(const Value& value) { *stackTop_++ = value; }
+  Value pop() { return std::move(*--stackTop_); }
+  Value& peek(int distance) { return stackTop_[-1 - distance]; }
+
+  void callValue(Value callee, int argCount);
+  void call(Closure* closure, int argCount);
+  void invoke(const std::string& name, int argCount);
+  void invokeFromClass(Class* klass, const std::string& name, int argCount);
+  bool bindMethod(Class* klass, const std::string& name);
+  void checkArity(int arity, int argCount);
+  Upvalue* captureUpvalue(Value* local);
+  void closeUpvalues(Value* last);
+  void defineNative(const std::string& name, int arity, NativeFn function);
+
+  lox::lang::RuntimeError error(const std::string& message) const;
+};
+
+}  // namespace vm
+}  // namespace lox
@@ -0,0 +1,35 @@
+#include "Value.h"
+
+#include "LoxString.h"
+
+namespace lox {
+namespace lang {
+
+bool Value::isTruthy() const {
+  if (isBool()) {
+    return asBool();
+  }
+  if (isNil()) {
+    return false;
+  }
+  if (isNumber()) {
+    return asNumber() != 0;
+  }
+  if (isString()) {
+    return as<LoxString>()->length() != 0;
+  }
+  return true;
+}
+
+bool Value::equals(const Value& other) const {
+  if (isNumber() && other.isNumber()) {
+    return asNumber() == other.asNumber();
+  }
+  if (isString() && other.isString()) {
+    return as<LoxString>()->equals(other.as<LoxString>());
+  }
+  return bits_ == other.bits_;
+}
+
+}  // namespace lang
+}  // namespace lox
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "LoxObject.h"
+
+namespace lox {
+namespace lang {
+
+// A Lox value packed into 64 bits. Numbers are stored as plain doubles, every
+// other value lives inside the payload of a quiet NaN:
+//   nil, false, true - small tags in the low bits
+//   objects          - sign bit set, 48 bit pointer in the low bits
+// Objects are owned by the Heap, copying a Value copies the bits only.
+class Value {
+ public:
+  Value() : bits_(kNil) {}
+  Value(std::nullptr_t) : bits_(kNil) {}
+  Value(bool boolean) : bits_(boolean ? kTrue : kFalse) {}
+  Value(double number) { std::memcpy(&bits_, &number, sizeof(double)); }
+  Value(LoxObject* object)
+      : bits_(kSignBit | kQuietNan | reinterpret_cast<uintptr_t>(object)) {}
+  Value(const char*) = delete;
+
+  bool isNil() const { return bits_ == kNil; }
+  bool isBool() const { return (bits_ | 1) == kTrue; }
+  bool isNumber() const { return (bits_ & kQuietNan) != kQuietNan; }
+  bool isObject() const {
+    return (bits_ & (kSignBit | kQuietNan)) == (kSignBit | kQuietNan);
+  }
+  bool isObject(ObjectType type) const {
+    return isObject() && asObject()->type() == type;
+  }
+  bool isString() const { return isObject(ObjectType::String); }
+  bool isInstance() const { return isObject(ObjectType::Instance); }
+  bool isClass() const { return isObject(ObjectType::Class); }
+  bool isCallable() const {
+    if (!isObject()) return false;
+    auto type = asObject()->type();
+    return type == ObjectType::Function || type == ObjectType::Native ||
+           type == ObjectType::Class;
+  }
+
+  bool asBool() const { return bits_ == kTrue; }
+  double asNumber() const {
+    double number;
+    std::memcpy(&number, &bits_, sizeof(double));
+    return number;
+  }
+  LoxObject* asObject() const {
+    return reinterpret_cast<LoxObject*>(
+        static_cast<uintptr_t>(bits_ & ~(kSignBit | kQuietNan)));
+  }
+  template <typename T>
+  T* as() const {
+    return static_cast<T*>(asObject());
+  }
+
+  bool isTruthy() const;
+  bool equals(const Value& other) const;
+
+  // Identity comparison of the raw bits, see equals() for Lox equality.
+  bool operator==(const Value& other) const { return bits_ == other.bits_; }
+  bool operator!=(const Value& other) const { return bits_ != other.bits_; }
+
+ private:
+  static constexpr uint64_t kSignBit = 0x8000000000000000;
+  static constexpr uint64_t kQuietNan = 0x7ffc000000000000;
+  static constexpr uint64_t kNil = kQuietNan | 1;
+  static constexpr uint64_t kFalse = kQuietNan | 2;
+  static constexpr uint64_t kTrue = kQuietNan | 3;
+
+  uint64_t bits_;
+};
+
+static_assert(sizeof(Value) == sizeof(uint64_t), "Value must stay 64 bit");
+static_assert(std::is_trivially_copyable_v<Value>,
+              "Value must stay trivially copyable");
+
+}  // namespace lang
+}  // namespace lox
@@ -0,0 +1,143 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Chunk.h"
+#include "Heap.h"
+#include "LoxObject.h"
+#include "Value.h"
+
+namespace lox {
+namespace vm {
+
+using lox::lang::LoxObject;
+using lox::lang::Heap;
+using lox::lang::ObjectType;
+using lox::lang::Value;
+
+struct Function : public LoxObject {
+  explicit Function(const std::string& name)
+      : LoxObject(ObjectType::VmFunction),
+        name(name),
+        arity(0),
+        upvalueCount(0) {}
+
+  std::string toString() const override { return "Function " + name; }
+  void trace(Heap& heap) const override {
+    for (const auto& constant : chunk.constants) {
+      heap.mark(constant);
+    }
+  }
+
+  const std::string name;
+  int arity;
+  int upvalueCount;
+  Chunk chunk;
+};
+
+using NativeFn = Value (*)(int argCount, Value* args);
+
+struct Native : public LoxObject {
+  Native(const std::string& name, int arity, NativeFn function)
+      : LoxObject(ObjectType::VmNative),
+        name(name),
+        arity(arity),
+        function(function) {}
+
+  std::string toString() const override { return "Native Function " + name; }
+
+  const std::string name;
+  const int arity;
+  const NativeFn function;
+};
+
+// A variable captured by a closure. While the variable is still on the VM
+// stack the upvalue is open and points at the stack slot, once the slot goes
+// out of scope the value is moved into `closed`.
+struct Upvalue : public LoxObject {
+  explicit Upvalue(Value* location)
+      : LoxObject(ObjectType::VmUpvalue),
+        location(location),
+        next(nullptr) {}
+
+  std::string toString() const override { return "Upvalue"; }
+  void trace(Heap& heap) const override { heap.mark(closed); }
+
+  Value* location;
+  Value closed;
+  // Next open upvalue of the VM, ordered by stack slot.
+  Upvalue* next;
+};
+
+struct Closure : public LoxObject {
+  explicit Closure(Function* function)
+      : LoxObject(ObjectType::VmClosure),
+        function(function),
+        upvalues(function->upvalueCount, nullptr) {}
+
+  std::string toString() const override { return function->toString(); }
+  void trace(Heap& heap) const override {
+    heap.mark(function);
+    for (auto upvalue : upvalues) {
+      heap.mark(upvalue);
+    }
+  }
+
+  Function* const function;
+  std::vector<Upvalue*> upvalues;
+};
+
+struct Class : public LoxObject {
+  explicit Class(const std::string& name)
+      : LoxObject(ObjectType::VmClass), name(name) {}
+
+  std::string toString() const override { return "Class " + name; }
+  void trace(Heap& heap) const override {
+    for (const auto& [name, method] : methods) {
+      heap.mark(method);
+    }
+    heap.mark(initializer);
+  }
+
+  const std::string name;
+  std::unordered_map<std::string, Value> methods;
+  Value initializer;
+};
+
+struct Instance : public LoxObject {
+  explicit Instance(Class* klass)
+      : LoxObject(ObjectType::VmInstance), klass(klass) {}
+
+  std::string toString() const override {
+    return "Instance of " + klass->toString();
+  }
+  void trace(Heap& heap) const override {
+    heap.mark(klass);
+    for (const auto& [name, field] : fields) {
+      heap.mark(field);
+    }
+  }
+
+  Class* const klass;
+  std::unordered_map<std::string, Value> fields;
+};
+
+struct BoundMethod : public LoxObject {
+  BoundMethod(const Value& receiver, Closure* method)
+      : LoxObject(ObjectType::VmBoundMethod),
+        receiver(receiver),
+        method(method) {}
+
+  std::string toString() const override { return method->toString(); }
+  void trace(Heap& heap) const override {
+    heap.mark(receiver);
+    heap.mark(method);
+  }
+
+  const Value receiver;
+  Closure* const method;
+};
+
+}  // namespace vm
+}  // namespace lox
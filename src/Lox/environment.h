@@ -1,83 +1,88 @@
 #pragma once
-#include <any>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
-#include "Interpreter.h"
+#include "Heap.h"
+#include "LoxObject.h"
 #include "RuntimeError.h"
 #include "Token.h"
+#include "Value.h"
 
 namespace lox {
 namespace lang {
 
-class Environment {
+// Box holding a local variable captured by a closure. The frame of the
+// declaring function and every closure capturing the variable share the
+// cell, so the variable outlives the call creating it.
+class Cell : public LoxObject {
  public:
-  Environment() : parent_(nullptr) {}
-  Environment(std::shared_ptr<Environment> parent) : parent_(parent) {}
-  ~Environment() = default;
+  explicit Cell(const Value& value)
+      : LoxObject(ObjectType::Cell), value(value) {}
 
-  void define(const std::string& name, std::any value) {
-    values_.insert({name, value});
-  }
+  std::string toString() const override { return "Cell"; }
+  void trace(Heap& heap) const override { heap.mark(value); }
 
-  void define(const lox::parser::Token& name, const std::any& value) {
-    values_.insert({name.lexeme, value});
-  }
+  Value value;
+};
 
-  void assign(const lox::parser::Token& name, std::any& value) {
-    auto it = values_.find(name.lexeme);
-    if (it != values_.end()) {
-      it->second = value;
-      return;
-    }
-    if (parent_) {
-      parent_->assign(name, value);
-      return;
+// Global variables. A name is mapped to its slot once, when the resolver
+// first sees it, afterwards reads and writes index the table directly.
+// Names are interned identifiers or literals, so the keys never dangle.
+class Globals {
+ public:
+  int slot(std::string_view name) {
+    auto it = slots_.find(name);
+    if (it != slots_.end()) {
+      return it->second;
     }
-    throw RuntimeError(name,
-                       "Assinment to unbound variable '" + name.lexeme + "'.");
+    int slot = values_.size();
+    slots_.insert({name, slot});
+    values_.emplace_back(nullptr);
+    defined_.push_back(false);
+    return slot;
   }
 
-  void assignAt(const lox::parser::Token& name, std::any& value, int distance) {
-    if (distance == 0) {
-      assign(name, value);
-    } else {
-      ancestor(distance)->assign(name, value);
-    }
+  void define(std::string_view name, const Value& value) {
+    define(slot(name), value);
   }
 
-  std::any get(const lox::parser::Token& name) const {
-    auto it = values_.find(name.lexeme);
-    if (it != values_.end()) {
-      return it->second;
-    }
-    if (parent_) {
-      return parent_->get(name);
+  void define(int slot, const Value& value) {
+    values_[slot] = value;
+    defined_[slot] = true;
+  }
+
+  const Value& get(int slot, const lox::parser::Token& name) const {
+    if (!defined_[slot]) {
+      throw RuntimeError(
+          name, "Undefined variable '" + std::string(name.lexeme) + "'.");
     }
-    throw RuntimeError(name, "Undefined variable '" + name.lexeme + "'.");
+    return values_[slot];
   }
 
-  std::any getAt(const lox::parser::Token& name, int distance) const {
-    distance = std::max(distance, 0);
-    if (distance == 0) {
-      return get(name);
-    } else {
-      return ancestor(distance)->get(name);
+  void assign(int slot, const lox::parser::Token& name, const Value& value) {
+    if (!defined_[slot]) {
+      throw RuntimeError(name, "Assinment to unbound variable '" +
+                                   std::string(name.lexeme) + "'.");
     }
+    values_[slot] = value;
   }
 
-  std::shared_ptr<Environment> ancestor(int distance) const {
-    if (distance == 1) {
-      return parent_;
-    } else {
-      return parent_->ancestor(distance - 1);
+  // The table itself, for compiled code to read.
+  const Value* values() const { return values_.data(); }
+
+  void mark(Heap& heap) const {
+    for (const auto& value : values_) {
+      heap.mark(value);
     }
   }
 
  private:
-  std::unordered_map<std::string, std::any> values_;
-  std::shared_ptr<Environment> parent_;
+  std::unordered_map<std::string_view, int> slots_;
+  std::vector<Value> values_;
+  std::vector<bool> defined_;
 };
 
 }  // namespace lang
-}  // namespace lox
\ No newline at end of file
+}  // namespace lox
@@ -1,15 +1,22 @@
 #pragma once
 
-#include <any>
 #include <iostream>
 #include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
 
+#include "Arena.h"
+#include "Heap.h"
+#include "InlineCache.h"
 #include "Token.h"
+#include "Value.h"
 
 namespace lox {
+namespace lang {
+class Interpreter;
+}  // namespace lang
+
 namespace parser {
 
 struct Expression;
@@ -31,203 +38,247 @@ struct Super;
 
 class ExpressionVisitor {
  public:
-  virtual std::any visit(std::shared_ptr<const Binary> expr) = 0;
-  virtual std::any visit(std::shared_ptr<const Grouping> expr) = 0;
-  virtual std::any visit(std::shared_ptr<const Unary> expr) = 0;
-  virtual std::any visit(std::shared_ptr<const Literal> expr) = 0;
-  virtual std::any visit(std::shared_ptr<const Variable> expr) = 0;
-  virtual std::any visit(std::shared_ptr<const Sequence> expr) = 0;
-  virtual std::any visit(std::shared_ptr<const Ternary> expr) = 0;
-  virtual std::any visit(std::shared_ptr<const Assignment> expr) = 0;
-  virtual std::any visit(std::shared_ptr<const Call> expr) = 0;
-  virtual std::any visit(std::shared_ptr<const Lambda> expr) = 0;
-  virtual std::any visit(std::shared_ptr<const Get> expr) = 0;
-  virtual std::any visit(std::shared_ptr<const Set> expr) = 0;
-  virtual std::any visit(std::shared_ptr<const This> expr) = 0;
-  virtual std::any visit(std::shared_ptr<const Super> expr) = 0;
+  virtual lox::lang::Value visit(const Binary* expr) = 0;
+  virtual lox::lang::Value visit(const Grouping* expr) = 0;
+  virtual lox::lang::Value visit(const Unary* expr) = 0;
+  virtual lox::lang::Value visit(const Literal* expr) = 0;
+  virtual lox::lang::Value visit(const Variable* expr) = 0;
+  virtual lox::lang::Value visit(const Sequence* expr) = 0;
+  virtual lox::lang::Value visit(const Ternary* expr) = 0;
+  virtual lox::lang::Value visit(const Assignment* expr) = 0;
+  virtual lox::lang::Value visit(const Call* expr) = 0;
+  virtual lox::lang::Value visit(const Lambda* expr) = 0;
+  virtual lox::lang::Value visit(const Get* expr) = 0;
+  virtual lox::lang::Value visit(const Set* expr) = 0;
+  virtual lox::lang::Value visit(const This* expr) = 0;
+  virtual lox::lang::Value visit(const Super* expr) = 0;
   virtual ~ExpressionVisitor() = default;
 };
 
+// Resolution of a variable reference or declaration, filled in by the
+// Resolver. Locals live in the frame of the function declaring them, unless
+// a closure captures them: those are boxed into a Cell the frame slot
+// points to, and closures reach the cell through their upvalues.
+struct Binding {
+  enum class Kind : uint8_t {
+    Unresolved,
+    // Slot `index` of the global table.
+    Global,
+    // Slot `index` of the current frame.
+    Local,
+    // The Cell in slot `index` of the current frame.
+    Cell,
+    // Upvalue `index` of the running closure.
+    Upvalue,
+  };
+
+  Kind kind = Kind::Unresolved;
+  int index = 0;
+};
+
+// How a closure obtains one of its upvalues when it is created: the cell in
+// slot `index` of the enclosing frame, or upvalue `index` of the enclosing
+// closure.
+struct Capture {
+  bool isLocal;
+  int index;
+};
+
 struct Expression {
-  virtual std::any accept(ExpressionVisitor* visitor) const = 0;
+  virtual lox::lang::Value accept(ExpressionVisitor* visitor) const = 0;
   virtual ~Expression() = default;
 };
 
-struct Binary : Expression, public std::enable_shared_from_this<Binary> {
-  Binary(const std::shared_ptr<Expression>& left, const Token& op,
-         const std::shared_ptr<Expression>& right)
-      : left(std::move(left)), op(op), right(std::move(right)) {}
+struct Binary : Expression {
+  using Handler =
+      lox::lang::Value (lox::lang::Interpreter::*)(const Binary* expr);
+
+  Binary(Expression* left, const Token& op, Expression* right)
+      : left(left), op(op), right(right) {}
 
-  std::any accept(ExpressionVisitor* visitor) const override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(ExpressionVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
-  const std::shared_ptr<Expression> left;
+  Expression* const left;
   const Token op;
-  const std::shared_ptr<Expression> right;
+  Expression* const right;
+  // Type feedback of the interpreter. A node whose operands were numbers is
+  // quickened: it runs a handler specialized for its operator on numbers,
+  // behind a guard on the operand types. The first operands of another type
+  // send the node back to the generic path, for good.
+  mutable Handler quickened = nullptr;
+  mutable bool generic = false;
 };
 
-struct Grouping : public Expression, std::enable_shared_from_this<Grouping> {
-  Grouping(const std::shared_ptr<Expression>& exp)
-      : expression(std::move(exp)) {}
+struct Grouping : public Expression {
+  Grouping(Expression* exp) : expression(exp) {}
 
-  std::any accept(ExpressionVisitor* visitor) const override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(ExpressionVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
-  const std::shared_ptr<Expression> expression;
+  Expression* const expression;
 };
 
-struct Unary : public Expression, std::enable_shared_from_this<Unary> {
-  Unary(const Token& op, const std::shared_ptr<Expression>& right)
-      : op(op), right(std::move(right)) {}
+struct Unary : public Expression {
+  Unary(const Token& op, Expression* right) : op(op), right(right) {}
 
-  std::any accept(ExpressionVisitor* visitor) const override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(ExpressionVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
   const Token op;
-  const std::shared_ptr<Expression> right;
+  Expression* const right;
 };
 
-struct Literal : public Expression, std::enable_shared_from_this<Literal> {
-  Literal(const std::any& value) : value(value) {}
+struct Literal : public Expression {
+  // String literals are referenced by the tree alone, pin them for as long
+  // as the tree lives.
+  Literal(const lox::lang::Value& value) : value(value) {
+    lox::lang::heap().pin(value);
+  }
+  ~Literal() { lox::lang::heap().unpin(value); }
 
-  std::any accept(ExpressionVisitor* visitor) const override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(ExpressionVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
-  const std::any value;
+  const lox::lang::Value value;
 };
 
-struct Variable : public Expression, std::enable_shared_from_this<Variable> {
+struct Variable : public Expression {
   Variable(const Token& token) : token(token) {}
 
-  std::any accept(ExpressionVisitor* visitor) const override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(ExpressionVisitor* visitor) const override {
+    return visitor->visit(this);
   }
   const Token token;
+  mutable Binding binding;
 };
 
-struct Sequence : public Expression, std::enable_shared_from_this<Sequence> {
-  Sequence() {}
+struct Sequence : public Expression {
+  explicit Sequence(Span<Expression*> expressions)
+      : expressions(expressions) {}
 
-  std::any accept(ExpressionVisitor* visitor) const override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(ExpressionVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
-  std::vector<const std::shared_ptr<Expression>> expressions;
+  const Span<Expression*> expressions;
 };
 
-struct Ternary : public Expression, std::enable_shared_from_this<Ternary> {
-  Ternary(const std::shared_ptr<Expression>& predicate,
-          const std::shared_ptr<Expression>& then)
-      : predicate(std::move(predicate)),
-        then(std::move(then)),
-        alternative(nullptr) {}
+struct Ternary : public Expression {
+  Ternary(Expression* predicate, Expression* then)
+      : predicate(predicate), then(then), alternative(nullptr) {}
 
-  Ternary(const std::shared_ptr<Expression>& predicate,
-          const std::shared_ptr<Expression>& then,
-          const std::shared_ptr<Expression>& alternative)
-      : predicate(std::move(predicate)),
-        then(std::move(then)),
-        alternative(std::move(alternative)) {}
+  Ternary(Expression* predicate, Expression* then, Expression* alternative)
+      : predicate(predicate), then(then), alternative(alternative) {}
 
-  std::any accept(ExpressionVisitor* visitor) const override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(ExpressionVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
-  const std::shared_ptr<Expression> predicate;
-  const std::shared_ptr<Expression> then;
-  const std::shared_ptr<Expression> alternative;
+  Expression* const predicate;
+  Expression* const then;
+  Expression* const alternative;
 };
 
-struct Assignment : Expression,
-                    public std::enable_shared_from_this<Assignment> {
-  Assignment(const Token& token, const std::shared_ptr<Expression>& target)
-      : token(token), target(std::move(target)) {}
+struct Assignment : Expression {
+  Assignment(const Token& token, Expression* target)
+      : token(token), target(target) {}
 
-  std::any accept(ExpressionVisitor* visitor) const override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(ExpressionVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
   const Token token;
-  const std::shared_ptr<Expression> target;
+  Expression* const target;
+  mutable Binding binding;
 };
 
-struct Call : Expression, public std::enable_shared_from_this<Call> {
-  Call(const std::shared_ptr<Expression>& callee, const Token& paren,
-       const std::shared_ptr<Expression>& arguments)
-      : callee(std::move(callee)),
-        paren(paren),
-        arguments(std::move(arguments)) {}
+struct Lambda : public Expression {
+  explicit Lambda(Function* function)
+      : function(function) {}
 
-  std::any accept(ExpressionVisitor* visitor) const override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(ExpressionVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
-  const std::shared_ptr<Expression> callee;
-  const Token paren;
-  const std::shared_ptr<Expression> arguments;
+  Function* const function;
 };
 
-struct Lambda : public Expression, std::enable_shared_from_this<Lambda> {
-  explicit Lambda(const std::shared_ptr<Function>& function)
-      : function(std::move(function)) {}
+struct Get : public Expression {
+  Get(Expression* object, const Token& name) : object(object), name(name) {}
 
-  std::any accept(ExpressionVisitor* visitor) const override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(ExpressionVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
-  const std::shared_ptr<Function> function;
+  Expression* const object;
+  const Token name;
+  mutable lox::lang::PropertyCache cache{lox::lang::inlineCacheStats().get};
 };
 
-struct Get : public Expression, std::enable_shared_from_this<Get> {
-  Get(const std::shared_ptr<Expression>& object, const Token& name)
-      : object(std::move(object)), name(name) {}
+struct Set : public Expression {
+  Set(Expression* object, const Token& name, Expression* value)
+      : object(object), name(name), value(value) {}
 
-  std::any accept(ExpressionVisitor* visitor) const override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(ExpressionVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
-  const std::shared_ptr<Expression> object;
+  Expression* const object;
   const Token name;
+  Expression* const value;
+  mutable lox::lang::PropertyCache cache{lox::lang::inlineCacheStats().set};
 };
 
-struct Set : public Expression, std::enable_shared_from_this<Set> {
-  Set(const std::shared_ptr<Expression>& object, const Token& name,
-      const std::shared_ptr<Expression>& value)
-      : object(std::move(object)), name(name), value(std::move(value)) {}
+struct Call : Expression {
+  Call(Expression* callee, const Token& paren, Expression* arguments)
+      : callee(callee),
+        paren(paren),
+        arguments(arguments),
+        method(dynamic_cast<Get*>(callee)) {}
 
-  std::any accept(ExpressionVisitor* visitor) const override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(ExpressionVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
-  const std::shared_ptr<Expression> object;
-  const Token name;
-  const std::shared_ptr<Expression> value;
+  Expression* const callee;
+  const Token paren;
+  Expression* const arguments;
+  // The callee when calling a method, `object.name(...)`. Method calls look
+  // the method up through their own cache.
+  Get* const method;
+  mutable lox::lang::PropertyCache cache{
+      lox::lang::inlineCacheStats().invoke};
 };
 
-struct This : public Expression, std::enable_shared_from_this<This> {
+struct This : public Expression {
   explicit This(const Token& token) : token(token) {}
 
-  std::any accept(ExpressionVisitor* visitor) const override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(ExpressionVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
   const Token token;
+  mutable Binding binding;
 };
 
-struct Super : public Expression, std::enable_shared_from_this<Super> {
+struct Super : public Expression {
   Super(const Token& keyword, const Token& method)
       : keyword(keyword), method(method) {}
 
-  std::any accept(ExpressionVisitor* visitor) const override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(ExpressionVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
   const Token keyword;
   const Token method;
+  mutable Binding binding;
+  // Binding of "this", the receiver the method is looked up for.
+  mutable Binding receiver;
 };
 
 }  // namespace parser
@@ -1,138 +1,262 @@
 #include "Interpreter.h"
 
+#include <algorithm>
+#include <functional>
 #include <string>
+#include <type_traits>
 
-#include "ControlException.h"
 #include "LoxCallable.h"
 #include "LoxClass.h"
 #include "LoxFunction.h"
 #include "LoxNative.h"
+#include "LoxString.h"
 #include "lox.h"
 #include "utils.h"
 
 namespace lox {
 namespace lang {
 
-Interpreter::Interpreter() : globals_(std::make_shared<Environment>()) {
-  auto clock_ptr = std::make_shared<Clock>();
-  auto clock = std::make_any<std::shared_ptr<LoxCallable>>(clock_ptr);
-  globals_->define("clock", clock);
-  env_ = globals_;
+Interpreter::Interpreter()
+    : frames_{{nullptr, 0}},
+      maxCallDepth_(kDefaultMaxCallDepth),
+      jitThreshold_(Jit::kDefaultThreshold),
+      profiler_(nullptr),
+      lineProfile_(nullptr),
+      heapProfile_(nullptr),
+      frame_(0),
+      top_(0),
+      function_(nullptr),
+      completion_(Completion::Normal),
+      returnValue_(nullptr) {
+  globals_.define("clock", makeObject<Clock>());
+  heap().addRoots(this);
+}
+
+Interpreter::~Interpreter() { heap().removeRoots(this); }
+
+void Interpreter::markRoots(Heap& heap) {
+  globals_.mark(heap);
+  for (size_t i = 0; i < top_; i++) {
+    heap.mark(stack_[i]);
+  }
+  // Bound methods are replaced by their receiver in the callee slot, the
+  // frames keep them alive until they return.
+  for (const auto& frame : frames_) {
+    heap.mark(frame.function);
+  }
+  heap.mark(returnValue_);
 }
 
-void Interpreter::evaluate(
-    const std::vector<std::shared_ptr<lox::parser::Statement>>& stmt) {
+void Interpreter::evaluate(const std::vector<lox::parser::Statement*>& stmt) {
   for (auto& s : stmt) {
+    heap().safepoint();
+    profile();
+    size_t top = top_;
     try {
       if (s) {
         execute(s);
       }
     } catch (RuntimeError& error) {
       lox::lang::Lox::runtime_error(error);
+      // Unwind the calls the error interrupted.
+      frames_.resize(1);
+      frame_ = 0;
+      top_ = top;
+      function_ = nullptr;
     }
+    completion_ = Completion::Normal;
   }
 }
 
-void Interpreter::evaluate(const std::shared_ptr<lox::parser::Block>& block,
-                           std::shared_ptr<Environment> env) {
-  execute(block->statements, env);
+void Interpreter::reserveSlots(int count) {
+  if (stack_.size() < count) {
+    stack_.resize(count);
+  }
+  top_ = std::max<size_t>(top_, count);
+}
+
+Value Interpreter::call(LoxFunction* function, LoxInstance* receiver,
+                        int argCount) {
+  const auto* declaration = function->declaration();
+  size_t base = top_ - argCount - 1;
+  Value compiled;
+  if (!receiver && runCompiled(function, argCount, compiled)) {
+    top_ = base;
+    profile(function);
+    return compiled;
+  }
+  size_t top = base + declaration->slots;
+  if (stack_.size() < top) {
+    stack_.resize(std::max(top, 2 * stack_.size()));
+  }
+
+  // Slots past the arguments may hold objects of finished frames the
+  // collector has freed since, clear them before they become roots.
+  Value* slots = &stack_[base];
+  if (receiver) {
+    slots[0] = receiver;
+  }
+  std::fill(slots + argCount + 1, slots + declaration->slots, Value());
+  for (int boxed : declaration->boxedParameters) {
+    slots[boxed] = makeObject<Cell>(slots[boxed]);
+  }
+
+  frames_.push_back({function, base});
+  frame_ = base;
+  top_ = top;
+  function_ = function;
+  execute(declaration->body->statements);
+  frames_.pop_back();
+  frame_ = frames_.back().base;
+  top_ = base;
+  function_ = frames_.back().function;
+
+  if (completion_ != Completion::Return) {
+    completion_ = Completion::Normal;
+    return nullptr;
+  }
+  completion_ = Completion::Normal;
+  Value result = returnValue_;
+  returnValue_ = nullptr;
+  return result;
 }
 
-void Interpreter::resolve(std::shared_ptr<const lox::parser::Expression> expr,
-                          int depth) {
-  locals_.insert({expr, depth});
+bool Interpreter::runCompiled(LoxFunction* function, int argCount,
+                              Value& result) {
+  auto& jit = function->declaration()->jit;
+  if (jit.disabled || !jitThreshold_) {
+    return false;
+  }
+  if (!jit.code) {
+    if (++jit.calls < jitThreshold_) {
+      return false;
+    }
+    if (!jit_.compile(function->declaration(), globals_)) {
+      jit.disabled = true;
+      return false;
+    }
+  }
+
+  // Compiled code only handles numbers, the parser allows 255 arguments.
+  double args[256];
+  const Value* values = &stack_[top_ - argCount];
+  for (int i = 0; i < argCount; i++) {
+    if (!values[i].isNumber()) {
+      return false;
+    }
+    args[i] = values[i].asNumber();
+  }
+  // The calls visit(Call) would still allow, counting this one.
+  JitContext context{globals_.values(),
+                     maxCallDepth_ - static_cast<int64_t>(frames_.size()) + 1};
+  double number;
+  if (jit.code(args, &number, &context)) {
+    result = number;
+    return true;
+  }
+  if (++jit.bailouts >= Jit::kMaxBailouts) {
+    jit.disabled = true;
+  }
+  return false;
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Literal> expr) {
+Value Interpreter::visit(const lox::parser::Literal* expr) {
   return expr->value;
 }
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Grouping> expr) {
+Value Interpreter::visit(const lox::parser::Grouping* expr) {
   return evaluate(expr->expression);
 }
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Unary> expr) {
+Value Interpreter::visit(const lox::parser::Unary* expr) {
   auto right = evaluate(expr->right);
 
   switch (expr->op.type) {
     case lox::parser::Token::TokenType::MINUS:
       checkNumberOperand(expr->op, right);
-      return -(std::any_cast<double>(right));
+      return -right.asNumber();
     case lox::parser::Token::TokenType::BANG:
-      return isTruthy(right);
+      return !right.isTruthy();
     case lox::parser::Token::TokenType::MINUS_MINUS:
       checkNumberOperand(expr->op, right);
-      return std::any_cast<double>(right) - 1;
+      return right.asNumber() - 1;
     case lox::parser::Token::TokenType::PLUS_PLUS:
       checkNumberOperand(expr->op, right);
-      return std::any_cast<double>(right) + 1;
+      return right.asNumber() + 1;
     default:
       return nullptr;
   }
 }
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Binary> expr) {
+Value Interpreter::visit(const lox::parser::Binary* expr) {
+  if (expr->quickened) {
+    return (this->*expr->quickened)(expr);
+  }
+
   auto left = evaluate(expr->left);
   switch (expr->op.type) {
     case lox::parser::Token::TokenType::AND:
-      if (isTruthy(left)) {
-        return isTruthy(evaluate(expr->right));
+      if (left.isTruthy()) {
+        return evaluate(expr->right).isTruthy();
       }
       return false;
     case lox::parser::Token::TokenType::OR:
-      if (isTruthy(left)) {
+      if (left.isTruthy()) {
         return true;
       }
-      return isTruthy(evaluate(expr->right));
+      return evaluate(expr->right).isTruthy();
     default:
-      break;
+      return binary(expr, left);
   }
+}
 
+Value Interpreter::binary(const lox::parser::Binary* expr, const Value& left) {
+  TempRoots roots;
+  roots.push(left);
   auto right = evaluate(expr->right);
-  auto& left_type = left.type();
-  auto& right_type = right.type();
+  if (left.isNumber() && right.isNumber() && !expr->generic) {
+    quicken(expr);
+  }
+  return binary(expr, left, right);
+}
 
+Value Interpreter::binary(const lox::parser::Binary* expr, const Value& left,
+                          const Value& right) {
   switch (expr->op.type) {
     case lox::parser::Token::TokenType::BANG_EQUAL:
-      return !isEqual(left, right);
+      return !left.equals(right);
     case lox::parser::Token::TokenType::EQUAL_EQUAL:
-      return isEqual(left, right);
+      return left.equals(right);
     case lox::parser::Token::TokenType::GREATER:
       checkNumberOperands(expr->op, left, right);
-      return std::any_cast<double&>(left) > std::any_cast<double&>(right);
+      return left.asNumber() > right.asNumber();
     case lox::parser::Token::TokenType::GREATER_EQUAL:
       checkNumberOperands(expr->op, left, right);
-      return std::any_cast<double&>(left) >= std::any_cast<double&>(right);
+      return left.asNumber() >= right.asNumber();
     case lox::parser::Token::TokenType::LESS:
       checkNumberOperands(expr->op, left, right);
-      return std::any_cast<double&>(left) < std::any_cast<double&>(right);
+      return left.asNumber() < right.asNumber();
     case lox::parser::Token::TokenType::LESS_EQUAL:
       checkNumberOperands(expr->op, left, right);
-      return std::any_cast<double&>(left) <= std::any_cast<double&>(right);
+      return left.asNumber() <= right.asNumber();
     case lox::parser::Token::TokenType::PLUS:
-      if (left_type == typeid(double) && right_type == typeid(double)) {
-        return std::any_cast<double&>(left) + std::any_cast<double&>(right);
-      }
-      if (left_type == typeid(std::string) &&
-          right_type == typeid(std::string)) {
-        return std::any_cast<std::string>(left) +
-               std::any_cast<std::string>(right);
+      if (left.isNumber() && right.isNumber()) {
+        return left.asNumber() + right.asNumber();
       }
-      if (left_type == typeid(std::string) ||
-          right_type == typeid(std::string)) {
-        return lox::util::any_to_string(left) + lox::util::any_to_string(right);
+      if (left.isString() || right.isString()) {
+        return concatenate(left, right);
       }
       throw RuntimeError(expr->op,
                          "Operands must be either numbers or strings.");
     case lox::parser::Token::TokenType::MINUS:
       checkNumberOperands(expr->op, left, right);
-      return std::any_cast<double>(left) - std::any_cast<double>(right);
+      return left.asNumber() - right.asNumber();
     case lox::parser::Token::TokenType::STAR:
       checkNumberOperands(expr->op, left, right);
-      return std::any_cast<double>(left) * std::any_cast<double>(right);
+      return left.asNumber() * right.asNumber();
     case lox::parser::Token::TokenType::SLASH:
       checkNumberOperands(expr->op, left, right);
-      if (std::any_cast<double>(right) == 0) {
+      if (right.asNumber() == 0) {
         throw ZeroDivision(expr->op, "Second operand must be non-zero.");
       }
-      return std::any_cast<double>(left) / std::any_cast<double>(right);
+      return left.asNumber() / right.asNumber();
     default:
       break;
   }
@@ -140,7 +264,105 @@ std::any Interpreter::visit(std::shared_ptr<const lox::parser::Binary> expr) {
   return nullptr;
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Sequence> expr) {
+void Interpreter::quicken(const lox::parser::Binary* expr) {
+  auto literal = dynamic_cast<const lox::parser::Literal*>(expr->right);
+  bool constant = literal && literal->value.isNumber();
+  auto install = [&](lox::parser::Binary::Handler numbers,
+                     lox::parser::Binary::Handler numberConstant) {
+    expr->quickened = constant ? numberConstant : numbers;
+  };
+  switch (expr->op.type) {
+    case lox::parser::Token::TokenType::BANG_EQUAL:
+      install(&Interpreter::numbers<std::not_equal_to<double>>,
+              &Interpreter::numberConstant<std::not_equal_to<double>>);
+      break;
+    case lox::parser::Token::TokenType::EQUAL_EQUAL:
+      install(&Interpreter::numbers<std::equal_to<double>>,
+              &Interpreter::numberConstant<std::equal_to<double>>);
+      break;
+    case lox::parser::Token::TokenType::GREATER:
+      install(&Interpreter::numbers<std::greater<double>>,
+              &Interpreter::numberConstant<std::greater<double>>);
+      break;
+    case lox::parser::Token::TokenType::GREATER_EQUAL:
+      install(&Interpreter::numbers<std::greater_equal<double>>,
+              &Interpreter::numberConstant<std::greater_equal<double>>);
+      break;
+    case lox::parser::Token::TokenType::LESS:
+      install(&Interpreter::numbers<std::less<double>>,
+              &Interpreter::numberConstant<std::less<double>>);
+      break;
+    case lox::parser::Token::TokenType::LESS_EQUAL:
+      install(&Interpreter::numbers<std::less_equal<double>>,
+              &Interpreter::numberConstant<std::less_equal<double>>);
+      break;
+    case lox::parser::Token::TokenType::PLUS:
+      install(&Interpreter::numbers<std::plus<double>>,
+              &Interpreter::numberConstant<std::plus<double>>);
+      break;
+    case lox::parser::Token::TokenType::MINUS:
+      install(&Interpreter::numbers<std::minus<double>>,
+              &Interpreter::numberConstant<std::minus<double>>);
+      break;
+    case lox::parser::Token::TokenType::STAR:
+      install(&Interpreter::numbers<std::multiplies<double>>,
+              &Interpreter::numberConstant<std::multiplies<double>>);
+      break;
+    case lox::parser::Token::TokenType::SLASH:
+      install(&Interpreter::numbers<std::divides<double>>,
+              &Interpreter::numberConstant<std::divides<double>>);
+      break;
+    default:
+      expr->generic = true;
+      break;
+  }
+}
+
+Value Interpreter::deoptimize(const lox::parser::Binary* expr,
+                              const Value& left) {
+  expr->quickened = nullptr;
+  expr->generic = true;
+  return binary(expr, left);
+}
+
+template <typename Op>
+Value Interpreter::numbers(const lox::parser::Binary* expr) {
+  auto left = evaluate(expr->left);
+  if (!left.isNumber()) {
+    return deoptimize(expr, left);
+  }
+  // A number needs no rooting while the right operand is evaluated.
+  auto right = evaluate(expr->right);
+  if (!right.isNumber()) {
+    expr->quickened = nullptr;
+    expr->generic = true;
+    return binary(expr, left, right);
+  }
+  return apply<Op>(expr, left.asNumber(), right.asNumber());
+}
+
+template <typename Op>
+Value Interpreter::numberConstant(const lox::parser::Binary* expr) {
+  auto left = evaluate(expr->left);
+  if (!left.isNumber()) {
+    return deoptimize(expr, left);
+  }
+  auto right = static_cast<const lox::parser::Literal*>(expr->right);
+  return apply<Op>(expr, left.asNumber(), right->value.asNumber());
+}
+
+template <typename Op>
+Value Interpreter::apply(const lox::parser::Binary* expr, double left,
+                         double right) {
+  if constexpr (std::is_same_v<Op, std::divides<double>>) {
+    if (right == 0) {
+      throw ZeroDivision(expr->op, "Second operand must be non-zero.");
+    }
+  }
+  return Op()(left, right);
+}
+
+Value Interpreter::visit(const lox::parser::Sequence* expr) {
   for (int i = 0; i < expr->expressions.size(); i++) {
     if (i == expr->expressions.size() - 1) {
       return evaluate(expr->expressions[i]);
@@ -150,9 +372,9 @@ std::any Interpreter::visit(std::shared_ptr<const lox::parser::Sequence> expr) {
   return nullptr;
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Ternary> expr) {
+Value Interpreter::visit(const lox::parser::Ternary* expr) {
   auto predicate = evaluate(expr->predicate);
-  if (isTruthy(predicate)) {
+  if (predicate.isTruthy()) {
     return evaluate(expr->then);
   } else if (expr->alternative) {
     return evaluate(expr->alternative);
@@ -160,79 +382,115 @@ std::any Interpreter::visit(std::shared_ptr<const lox::parser::Ternary> expr) {
   return nullptr;
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Variable> expr) {
-  return lookupVariable(expr->token, expr);
+Value Interpreter::visit(const lox::parser::Variable* expr) {
+  return lookupVariable(expr->token, expr->binding);
 }
 
-std::any Interpreter::visit(
-    std::shared_ptr<const lox::parser::Assignment> expr) {
+Value Interpreter::visit(const lox::parser::Assignment* expr) {
   auto value = evaluate(expr->target);
-  auto it = locals_.find(expr);
-  if (it == locals_.end()) {
-    globals_->assign(expr->token, value);
-  } else {
-    int distance = it->second;
-    env_->assignAt(expr->token, value, distance);
+  const auto& binding = expr->binding;
+  switch (binding.kind) {
+    case lox::parser::Binding::Kind::Global:
+      globals_.assign(binding.index, expr->token, value);
+      break;
+    case lox::parser::Binding::Kind::Local:
+      stack_[frame_ + binding.index] = value;
+      break;
+    case lox::parser::Binding::Kind::Cell:
+      stack_[frame_ + binding.index].as<Cell>()->value = value;
+      break;
+    case lox::parser::Binding::Kind::Upvalue:
+      function_->upvalue(binding.index)->value = value;
+      break;
+    case lox::parser::Binding::Kind::Unresolved:
+      checkResolved(expr->token, binding);
   }
   return nullptr;
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Call> expr) {
-  auto callee = evaluate(expr->callee);
+Value Interpreter::visit(const lox::parser::Call* expr) {
+  if (lineProfile_) {
+    LineProfile::Scope scope(*lineProfile_, expr->paren.line,
+                             LineProfile::Kind::Call);
+    return evaluateCall(expr);
+  }
+  return evaluateCall(expr);
+}
+
+Value Interpreter::evaluateCall(const lox::parser::Call* expr) {
+  if (frames_.size() > static_cast<size_t>(maxCallDepth_)) {
+    throw RuntimeError(expr->paren, "Stack overflow.");
+  }
 
-  std::vector<std::any> args;
+  size_t base = top_;
+  Value callee;
+  LoxInstance* receiver = nullptr;
+  LoxFunction* method = nullptr;
+  if (expr->method) {
+    // Methods are invoked on the receiver directly, without materializing
+    // a bound method.
+    auto object = evaluate(expr->method->object);
+    if (!object.isInstance()) {
+      throw RuntimeError(expr->method->name, "Only instances have properties.");
+    }
+    receiver = object.as<LoxInstance>();
+    method = receiver->resolve(expr->method->name, expr->cache, callee);
+  } else {
+    callee = evaluate(expr->callee);
+  }
+  // The callee slot keeps the callee, or the receiver of the method, alive
+  // while the arguments are evaluated into the slots after it.
+  push(method ? Value(receiver) : callee);
   if (lox::parser::Sequence* seq =
-          dynamic_cast<lox::parser::Sequence*>(expr->arguments.get())) {
+          dynamic_cast<lox::parser::Sequence*>(expr->arguments)) {
     for (const auto& arg : seq->expressions) {
-      args.push_back(evaluate(arg));
+      Value value = evaluate(arg);
+      push(value);
     }
   }
+  int argCount = top_ - base - 1;
 
-  std::shared_ptr<LoxCallable> function;
-  if (callee.type() == typeid(std::shared_ptr<LoxFunction>)) {
-    function = std::any_cast<std::shared_ptr<LoxFunction>>(callee);
-  } else if (callee.type() == typeid(std::shared_ptr<LoxClass>)) {
-    function = std::any_cast<std::shared_ptr<LoxClass>>(callee);
-  } else if (callee.type() == typeid(std::shared_ptr<LoxCallable>)) {
-    function = std::any_cast<std::shared_ptr<LoxCallable>>(callee);
+  Value result;
+  if (method) {
+    checkArity(expr->paren, argCount, method->arity());
+    result = method->invoke(*this, receiver, argCount);
   } else {
-    throw RuntimeError(expr->paren, "Can only call functions and classes.");
-  }
-
-  if (args.size() != function->arity()) {
-    throw RuntimeError(
-        expr->paren,
-        "Invalid argument number: arg number = " + std::to_string(args.size()) +
-            " function arity = " + std::to_string(function->arity()));
+    if (!callee.isCallable()) {
+      throw RuntimeError(expr->paren, "Can only call functions and classes.");
+    }
+    auto function = callee.as<LoxCallable>();
+    checkArity(expr->paren, argCount, function->arity());
+    result = function->call(*this, &stack_[base + 1], argCount);
   }
-  return function->call(*this, args);
+  top_ = base;
+  return result;
 }
 
-std::any Interpreter::visit(
-    std::shared_ptr<const lox::parser::StatementExpression> stmt) {
+Value Interpreter::visit(const lox::parser::StatementExpression* stmt) {
   evaluate(stmt->expression);
   return nullptr;
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Print> stmt) {
-  std::cout << "[Out]: " << lox::util::any_to_string(evaluate(stmt->expression))
+Value Interpreter::visit(const lox::parser::Print* stmt) {
+  std::cout << "[Out]: " << lox::util::to_string(evaluate(stmt->expression))
             << "\n";
   return nullptr;
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Var> stmt) {
-  std::any value = stmt->initializer ? evaluate(stmt->initializer) : nullptr;
-  env_->define(stmt->token, value);
+Value Interpreter::visit(const lox::parser::Var* stmt) {
+  declare(stmt->binding);
+  Value value = stmt->initializer ? evaluate(stmt->initializer) : nullptr;
+  define(stmt->binding, stmt->token, value);
   return nullptr;
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Block> stmt) {
-  execute(stmt->statements, std::make_shared<Environment>(this->env_));
+Value Interpreter::visit(const lox::parser::Block* stmt) {
+  execute(stmt->statements);
   return nullptr;
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::If> stmt) {
-  if (isTruthy(evaluate(stmt->predicate))) {
+Value Interpreter::visit(const lox::parser::If* stmt) {
+  if (evaluate(stmt->predicate).isTruthy()) {
     execute(stmt->then);
   } else if (stmt->alternative) {
     execute(stmt->alternative);
@@ -240,234 +498,244 @@ std::any Interpreter::visit(std::shared_ptr<const lox::parser::If> stmt) {
   return nullptr;
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::While> stmt) {
-  while (isTruthy(evaluate(stmt->condition))) {
-    try {
-      execute(stmt->body);
-    } catch (Continue&) {
-      continue;
-    } catch (Break&) {
+Value Interpreter::visit(const lox::parser::While* stmt) {
+  while (!stmt->condition || evaluate(stmt->condition).isTruthy()) {
+    heap().safepoint();
+    profile();
+    execute(stmt->body);
+    if (completion_ == Completion::Return) {
+      break;
+    }
+    bool exit = completion_ == Completion::Break;
+    completion_ = Completion::Normal;
+    if (exit) {
       break;
     }
   }
   return nullptr;
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Continue> stmt) {
-  throw Continue(stmt->token);
+Value Interpreter::visit(const lox::parser::Continue* stmt) {
+  completion_ = Completion::Continue;
+  return nullptr;
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Break> stmt) {
-  throw Break(stmt->token);
+Value Interpreter::visit(const lox::parser::Break* stmt) {
+  completion_ = Completion::Break;
+  return nullptr;
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Return> stmt) {
-  std::any return_value = nullptr;
-  if (stmt->value) {
-    return_value = stmt->value->accept(this);
-  }
-  throw Return(stmt->token, return_value);
+Value Interpreter::visit(const lox::parser::Return* stmt) {
+  returnValue_ = stmt->value ? evaluate(stmt->value) : nullptr;
+  completion_ = Completion::Return;
+  return nullptr;
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Lambda> expr) {
-  auto function = std::make_shared<LoxFunction>(expr->function, env_);
-  return std::make_any<std::shared_ptr<LoxCallable>>(function);
+Value Interpreter::visit(const lox::parser::Lambda* expr) {
+  return makeClosure(expr->function);
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Get> expr) {
+Value Interpreter::visit(const lox::parser::Get* expr) {
   auto object = evaluate(expr->object);
-  try {
-    auto instance = std::any_cast<std::shared_ptr<LoxInstance>>(object);
-    return instance->get(expr->name);
-  } catch (std::bad_any_cast&) {
+  if (!object.isInstance()) {
     throw RuntimeError(expr->name, "Only instances have properties.");
   }
-  return nullptr;
+  return object.as<LoxInstance>()->get(expr->name, expr->cache);
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Set> expr) {
+Value Interpreter::visit(const lox::parser::Set* expr) {
   auto object = evaluate(expr->object);
-  try {
-    auto instance = std::any_cast<std::shared_ptr<LoxInstance>>(object);
-    auto value = evaluate(expr->value);
-    instance->set(expr->name, value);
-    return value;
-  } catch (std::bad_any_cast&) {
+  if (!object.isInstance()) {
     throw RuntimeError(expr->name, "Only instances have properties.");
   }
-  return nullptr;
+  TempRoots roots;
+  roots.push(object);
+  auto value = evaluate(expr->value);
+  object.as<LoxInstance>()->set(expr->name, value, expr->cache);
+  return value;
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::This> expr) {
-  return lookupVariable(expr->token, expr);
+Value Interpreter::visit(const lox::parser::This* expr) {
+  return lookupVariable(expr->token, expr->binding);
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Super> expr) {
-  auto it = locals_.find(expr);
-  if (it == locals_.end()) {
+Value Interpreter::visit(const lox::parser::Super* expr) {
+  const auto& binding = expr->binding;
+  if (binding.kind == lox::parser::Binding::Kind::Unresolved ||
+      binding.kind == lox::parser::Binding::Kind::Global) {
     throw RuntimeError(expr->keyword, "Undefined super expression.");
   }
-  int distance = it->second;
 
-  auto superclass = std::any_cast<std::shared_ptr<LoxClass>>(
-      env_->getAt(expr->keyword, distance));
-  auto object = std::any_cast<std::shared_ptr<LoxInstance>>(env_->getAt(
-      lox::parser::Token(lox::parser::Token::TokenType::THIS, "this", 0),
-      distance - 1));
-  auto method = superclass->getMethod(expr->method.lexeme);
+  auto superclass = lookupVariable(expr->keyword, binding);
+  auto object = lookupVariable(expr->keyword, expr->receiver);
+  auto method = superclass.as<LoxClass>()->getMethod(expr->method.lexeme);
   if (method == nullptr) {
     throw RuntimeError(expr->method, "Undefined method.");
   }
-  return method->bind(object);
+  return method->bind(object.as<LoxInstance>());
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Function> stmt) {
-  auto function = std::make_shared<LoxFunction>(stmt, env_);
-  auto callable = std::make_any<std::shared_ptr<LoxCallable>>(function);
-  env_->define(stmt->name, callable);
+Value Interpreter::visit(const lox::parser::Function* stmt) {
+  // Declared first, so that a recursive local function captures itself.
+  declare(stmt->binding);
+  define(stmt->binding, stmt->name, makeClosure(stmt));
   return nullptr;
 }
 
-std::any Interpreter::visit(std::shared_ptr<const lox::parser::Class> stmt) {
-  std::shared_ptr<LoxClass> superclass = nullptr;
+Value Interpreter::visit(const lox::parser::Class* stmt) {
+  LoxClass* superclass = nullptr;
   if (stmt->superclass) {
     auto object = evaluate(stmt->superclass);
-    if (object.type() != typeid(std::shared_ptr<LoxClass>)) {
+    if (!object.isClass()) {
       throw RuntimeError(stmt->superclass->token,
                          "Superclass mast be a class.");
     }
-    superclass = std::any_cast<std::shared_ptr<LoxClass>>(object);
+    superclass = object.as<LoxClass>();
   }
 
-  env_->define(stmt->name.lexeme, nullptr);
-  if (stmt->superclass) {
-    env_ = std::make_shared<Environment>(env_);
-    env_->define("super", superclass);
+  declare(stmt->binding);
+  if (superclass) {
+    declare(stmt->superBinding);
+    define(stmt->superBinding, stmt->name, superclass);
   }
-  auto closure = std::shared_ptr<Environment>(env_);
 
-  std::unordered_map<std::string, std::shared_ptr<LoxFunction>> methods;
+  // Inherited methods are copied in once here, so that looking up a method
+  // never walks the superclass chain.
+  MethodTable methods = superclass ? superclass->methods() : MethodTable();
   for (const auto& method : stmt->methods) {
     bool isInitializer = method->name.lexeme == "init";
-    methods.insert({method->name.lexeme, std::make_shared<LoxFunction>(
-                                             method, closure, isInitializer)});
-  }
-  auto klass =
-      std::make_any<std::shared_ptr<LoxClass>>(std::make_shared<LoxClass>(
-          stmt->name.lexeme, superclass, std::move(methods)));
-  if (stmt->superclass) {
-    env_ = env_->ancestor(1);
+    methods.insert_or_assign(method->name.lexeme,
+                             makeClosure(method, isInitializer));
   }
-  env_->assign(stmt->name, klass);
+  Value klass = makeObject<LoxClass>(stmt->name.lexeme, superclass,
+                                     std::move(methods));
+  define(stmt->binding, stmt->name, klass);
 
   return nullptr;
 }
 
-std::any Interpreter::evaluate(
-    const std::shared_ptr<lox::parser::Expression>& expr) {
+Value Interpreter::evaluate(const lox::parser::Expression* expr) {
   return expr->accept(this);
 }
 
-void Interpreter::execute(const std::shared_ptr<lox::parser::Statement>& stmt) {
+void Interpreter::sample(LoxFunction* running) {
+  std::vector<const lox::parser::Function*> stack;
+  stack.reserve(frames_.size());
+  for (size_t i = 1; i < frames_.size(); i++) {
+    stack.push_back(frames_[i].function->declaration());
+  }
+  if (running) {
+    stack.push_back(running->declaration());
+  }
+  profiler_->record(stack);
+}
+
+void Interpreter::executeProfiled(const lox::parser::Statement* stmt) {
+  HeapProfile::Site site(heapProfile_, stmt->line);
+  if (lineProfile_) {
+    LineProfile::Scope scope(*lineProfile_, stmt->line,
+                             LineProfile::Kind::Statement);
+    stmt->accept(this);
+    return;
+  }
   stmt->accept(this);
 }
 
 void Interpreter::execute(
-    const std::vector<std::shared_ptr<lox::parser::Statement>>& statements,
-    std::shared_ptr<Environment> env) {
-  auto previous = this->env_;
-  try {
-    this->env_ = env;
-    for (auto stmt : statements) {
-      if (stmt) {
-        execute(stmt);
+    lox::parser::Span<lox::parser::Statement*> statements) {
+  for (auto stmt : statements) {
+    if (stmt) {
+      heap().safepoint();
+      profile();
+      execute(stmt);
+      if (completion_ != Completion::Normal) {
+        break;
       }
     }
-  } catch (Return& return_exception) {
-    this->env_ = previous;
-    throw return_exception;
-  } catch (RuntimeError& error) {
-    this->env_ = previous;
-    throw error;
   }
-  this->env_ = previous;
 }
 
-bool Interpreter::isTruthy(const std::any& object) const {
-  if (!object.has_value()) {
-    return false;
-  }
-
-  auto& object_type = object.type();
-  if (object_type == typeid(nullptr)) {
-    return false;
-  }
-  if (object_type == typeid(bool)) {
-    return std::any_cast<bool>(object);
-  }
-  if (object_type == typeid(double)) {
-    return std::any_cast<double>(object) != 0;
+LoxFunction* Interpreter::makeClosure(const lox::parser::Function* declaration,
+                                      bool isInitializer) {
+  std::vector<Cell*> upvalues;
+  upvalues.reserve(declaration->captures.size());
+  for (const auto& capture : declaration->captures) {
+    upvalues.push_back(capture.isLocal
+                           ? stack_[frame_ + capture.index].as<Cell>()
+                           : function_->upvalue(capture.index));
   }
-  if (object_type == typeid(std::string)) {
-    return std::any_cast<std::string>(object) != "";
-  }
-  return true;
+  return makeObject<LoxFunction>(declaration, std::move(upvalues),
+                                 isInitializer);
 }
 
-bool Interpreter::isEqual(const std::any& left, const std::any& right) const {
-  if (!left.has_value() && !right.has_value()) {
-    return true;
-  }
-  if (!left.has_value()) {
-    return false;
-  }
-
-  auto& left_type = left.type();
-  auto& right_type = right.type();
-
-  if (left_type == right_type) {
-    if (left_type == typeid(nullptr)) {
-      return true;
-    }
-    if (left_type == typeid(std::string)) {
-      return std::any_cast<std::string>(left) ==
-             std::any_cast<std::string>(right);
-    }
-    if (left_type == typeid(double)) {
-      return std::any_cast<double>(left) == std::any_cast<double>(right);
-    }
-    return false;
+void Interpreter::checkArity(const lox::parser::Token& paren, int argCount,
+                             int arity) const {
+  if (argCount != arity) {
+    throw RuntimeError(paren, "Invalid argument number: arg number = " +
+                                  std::to_string(argCount) +
+                                  " function arity = " + std::to_string(arity));
   }
-  return false;
-}
-bool Interpreter::checkType(const std::any& object,
-                            const std::type_info& type) const {
-  return object.type() == type;
 }
 
 void Interpreter::checkNumberOperand(const lox::parser::Token& token,
-                                     const std::any& object) const {
-  if (checkType(object, typeid(double))) return;
+                                     const Value& object) const {
+  if (object.isNumber()) return;
   throw RuntimeError(token, "Operand must be number.");
 }
 
 void Interpreter::checkNumberOperands(const lox::parser::Token& token,
-                                      const std::any& left,
-                                      const std::any& right) const {
-  auto& dti = typeid(double);
-  if (checkType(left, dti) && checkType(right, dti)) return;
+                                      const Value& left,
+                                      const Value& right) const {
+  if (left.isNumber() && right.isNumber()) return;
   throw RuntimeError(token, "Operands must be numbers.");
 }
 
-std::any Interpreter::lookupVariable(
-    const lox::parser::Token& name,
-    std::shared_ptr<const lox::parser::Expression> expr) {
-  auto it = locals_.find(expr);
-  if (it == locals_.end()) {
-    return globals_->get(name);
-  } else {
-    int distance = it->second;
-    return env_->getAt(name, distance);
+void Interpreter::declare(const lox::parser::Binding& binding) {
+  if (binding.kind == lox::parser::Binding::Kind::Cell) {
+    stack_[frame_ + binding.index] = makeObject<Cell>(nullptr);
+  }
+}
+
+void Interpreter::define(const lox::parser::Binding& binding,
+                         const lox::parser::Token& name, const Value& value) {
+  switch (binding.kind) {
+    case lox::parser::Binding::Kind::Global:
+      globals_.define(binding.index, value);
+      break;
+    case lox::parser::Binding::Kind::Local:
+      stack_[frame_ + binding.index] = value;
+      break;
+    case lox::parser::Binding::Kind::Cell:
+      stack_[frame_ + binding.index].as<Cell>()->value = value;
+      break;
+    default:
+      globals_.define(name.lexeme, value);
+      break;
+  }
+}
+
+void Interpreter::checkResolved(const lox::parser::Token& name,
+                                const lox::parser::Binding& binding) const {
+  if (binding.kind == lox::parser::Binding::Kind::Unresolved) {
+    throw RuntimeError(
+        name, "Undefined variable '" + std::string(name.lexeme) + "'.");
+  }
+}
+
+Value Interpreter::lookupVariable(const lox::parser::Token& name,
+                                  const lox::parser::Binding& binding) {
+  switch (binding.kind) {
+    case lox::parser::Binding::Kind::Global:
+      return globals_.get(binding.index, name);
+    case lox::parser::Binding::Kind::Local:
+      return stack_[frame_ + binding.index];
+    case lox::parser::Binding::Kind::Cell:
+      return stack_[frame_ + binding.index].as<Cell>()->value;
+    case lox::parser::Binding::Kind::Upvalue:
+      return function_->upvalue(binding.index)->value;
+    default:
+      checkResolved(name, binding);
+      return nullptr;
   }
 }
 }  // namespace lang
@@ -1,80 +1,200 @@
 #pragma once
-#include <any>
+#include <algorithm>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "Environment.h"
 #include "Expression.h"
+#include "Heap.h"
+#include "HeapProfile.h"
+#include "Jit.h"
+#include "LineProfile.h"
+#include "Profiler.h"
 #include "RuntimeError.h"
 #include "Statement.h"
+#include "Value.h"
 
 namespace lox {
 namespace lang {
 
+class LoxFunction;
+class LoxInstance;
+
+// How the last executed statement finished. Anything but Normal skips the
+// rest of the enclosing blocks until a loop or a function call consumes it,
+// so control flow costs a branch per statement instead of an exception.
+enum class Completion {
+  Normal,
+  Break,
+  Continue,
+  Return,
+};
+
 class Interpreter : public lox::parser::ExpressionVisitor,
-                    lox::parser::StatementVisitor {
+                    lox::parser::StatementVisitor,
+                    public RootSource {
  public:
+  // Calls nested deeper than this fail with a "Stack overflow." error
+  // instead of exhausting the native stack, every Lox call takes a few
+  // recursive C++ calls of the tree walk.
+  static constexpr int kDefaultMaxCallDepth = 4096;
+
   Interpreter();
+  ~Interpreter();
+
+  void evaluate(const std::vector<lox::parser::Statement*>& stmt);
+  // Runs `function` in a new frame made of the top `argCount` + 1 values of
+  // the stack, the callee and its arguments, and returns the value of its
+  // return statement, nil if there was none. Methods get `receiver` in place
+  // of the callee.
+  Value call(LoxFunction* function, LoxInstance* receiver, int argCount);
+  // Makes room for the locals of top level code in the frame at the bottom
+  // of the stack.
+  void reserveSlots(int count);
+  // Slot of the global named `name` in the global table.
+  int globalSlot(std::string_view name) { return globals_.slot(name); }
 
-  void evaluate(
-      const std::vector<std::shared_ptr<lox::parser::Statement>>& stmt);
-  void evaluate(const std::shared_ptr<lox::parser::Block>& stmt,
-                std::shared_ptr<Environment> env);
-  void resolve(std::shared_ptr<const lox::parser::Expression> expr, int depth);
+  void setMaxCallDepth(int depth) { maxCallDepth_ = depth; }
+  int maxCallDepth() const { return maxCallDepth_; }
+  // Calls after which a function is compiled to native code, 0 never
+  // compiles.
+  void setJitThreshold(uint32_t threshold) { jitThreshold_ = threshold; }
+  // Samples the call stack for `profiler` while it runs, nullptr stops.
+  void setProfiler(Profiler* profiler) { profiler_ = profiler; }
+  // Counts statements and calls per line into `profile`, nullptr stops.
+  void setLineProfile(LineProfile* profile) { lineProfile_ = profile; }
+  // Attributes allocations to the line of the running statement.
+  void setHeapProfile(HeapProfile* profile) { heapProfile_ = profile; }
 
   // AstVisitor
-  std::any visit(std::shared_ptr<const lox::parser::Literal> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Variable> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Grouping> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Unary> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Binary> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Sequence> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Ternary> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Assignment> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Call> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Lambda> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Get> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Set> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::This> expr) override;
-  std::any visit(std::shared_ptr<const lox::parser::Super> expr) override;
+  Value visit(const lox::parser::Literal* expr) override;
+  Value visit(const lox::parser::Variable* expr) override;
+  Value visit(const lox::parser::Grouping* expr) override;
+  Value visit(const lox::parser::Unary* expr) override;
+  Value visit(const lox::parser::Binary* expr) override;
+  Value visit(const lox::parser::Sequence* expr) override;
+  Value visit(const lox::parser::Ternary* expr) override;
+  Value visit(const lox::parser::Assignment* expr) override;
+  Value visit(const lox::parser::Call* expr) override;
+  Value visit(const lox::parser::Lambda* expr) override;
+  Value visit(const lox::parser::Get* expr) override;
+  Value visit(const lox::parser::Set* expr) override;
+  Value visit(const lox::parser::This* expr) override;
+  Value visit(const lox::parser::Super* expr) override;
 
   // StatementVisitor
-  std::any visit(
-      std::shared_ptr<const lox::parser::StatementExpression> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::Print> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::Var> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::Block> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::If> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::While> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::Continue> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::Break> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::Return> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::Function> stmt) override;
-  std::any visit(std::shared_ptr<const lox::parser::Class> stmt) override;
-
-  std::shared_ptr<Environment> environment() const { return env_; }
+  Value visit(const lox::parser::StatementExpression* stmt) override;
+  Value visit(const lox::parser::Print* stmt) override;
+  Value visit(const lox::parser::Var* stmt) override;
+  Value visit(const lox::parser::Block* stmt) override;
+  Value visit(const lox::parser::If* stmt) override;
+  Value visit(const lox::parser::While* stmt) override;
+  Value visit(const lox::parser::Continue* stmt) override;
+  Value visit(const lox::parser::Break* stmt) override;
+  Value visit(const lox::parser::Return* stmt) override;
+  Value visit(const lox::parser::Function* stmt) override;
+  Value visit(const lox::parser::Class* stmt) override;
+
+  // RootSource
+  void markRoots(Heap& heap) override;
 
  private:
-  std::shared_ptr<Environment> globals_;
-  std::shared_ptr<Environment> env_;
-  std::unordered_map<std::shared_ptr<const lox::parser::Expression>, int>
-      locals_;
-
-  std::any evaluate(const std::shared_ptr<lox::parser::Expression>& expr);
-  void execute(const std::shared_ptr<lox::parser::Statement>& stmt);
-  void execute(
-      const std::vector<std::shared_ptr<lox::parser::Statement>>& statements,
-      std::shared_ptr<Environment> env);
-
-  bool isTruthy(const std::any& object) const;
-  bool isEqual(const std::any& left, const std::any& right) const;
-  bool checkType(const std::any& object, const std::type_info& type) const;
+  // A call in progress, frames_[0] stands for top level code.
+  struct CallFrame {
+    // nullptr for top level code.
+    LoxFunction* function;
+    // Index of the first slot of the frame in stack_.
+    size_t base;
+  };
+
+  Globals globals_;
+  // Locals of the active calls, one frame after the other. A call pushes the
+  // callee and evaluates the arguments right after it, into the slots of the
+  // parameters, then extends them to a frame of the size the resolver
+  // computed for the function. Values past the end of the running frame,
+  // top_, are temporaries of the expression being evaluated.
+  std::vector<Value> stack_;
+  std::vector<CallFrame> frames_;
+  int maxCallDepth_;
+  Jit jit_;
+  uint32_t jitThreshold_;
+  Profiler* profiler_;
+  LineProfile* lineProfile_;
+  HeapProfile* heapProfile_;
+  // Base of the running frame and the running closure, cached from
+  // frames_.back().
+  size_t frame_;
+  size_t top_;
+  LoxFunction* function_;
+  Completion completion_;
+  // Operand of the return statement while completion_ is Return.
+  Value returnValue_;
+
+  Value evaluate(const lox::parser::Expression* expr);
+  void push(const Value& value) {
+    if (top_ == stack_.size()) {
+      stack_.resize(std::max<size_t>(2 * stack_.size(), 64));
+    }
+    stack_[top_++] = value;
+  }
+  // Runs the native code of `function` on the `argCount` arguments on top of
+  // the stack, compiling it once it is hot. Returns false if there is no
+  // code or it bailed out, the call has to be interpreted then.
+  bool runCompiled(LoxFunction* function, int argCount, Value& result);
+  // Records the call stack, with `running` on top if it is a compiled
+  // function, if the profiler's timer ticked since the last sample. Called
+  // at safepoints, the check is all it costs without a profiler.
+  void profile(LoxFunction* running = nullptr) {
+    if (profiler_ && Profiler::pending()) {
+      sample(running);
+    }
+  }
+  void sample(LoxFunction* running);
+  void execute(const lox::parser::Statement* stmt) {
+    if (lineProfile_ || heapProfile_) {
+      executeProfiled(stmt);
+      return;
+    }
+    stmt->accept(this);
+  }
+  void executeProfiled(const lox::parser::Statement* stmt);
+  void execute(lox::parser::Span<lox::parser::Statement*> statements);
+  Value evaluateCall(const lox::parser::Call* expr);
+  LoxFunction* makeClosure(const lox::parser::Function* declaration,
+                           bool isInitializer = false);
+
+  // Binary operators. The generic path applies the operator to any operands
+  // and quickens nodes seeing numbers, the quickened handlers guard that
+  // the operands still are numbers and deoptimize otherwise.
+  Value binary(const lox::parser::Binary* expr, const Value& left);
+  Value binary(const lox::parser::Binary* expr, const Value& left,
+               const Value& right);
+  void quicken(const lox::parser::Binary* expr);
+  Value deoptimize(const lox::parser::Binary* expr, const Value& left);
+  template <typename Op>
+  Value numbers(const lox::parser::Binary* expr);
+  // Superinstruction for a number literal on the right, e.g. `i < 10`.
+  template <typename Op>
+  Value numberConstant(const lox::parser::Binary* expr);
+  template <typename Op>
+  Value apply(const lox::parser::Binary* expr, double left, double right);
+
+  void checkArity(const lox::parser::Token& paren, int argCount,
+                  int arity) const;
   void checkNumberOperand(const lox::parser::Token& token,
-                          const std::any& object) const;
-  void checkNumberOperands(const lox::parser::Token& token,
-                           const std::any& left, const std::any& right) const;
-  std::any lookupVariable(const lox::parser::Token& name,
-                          std::shared_ptr<const lox::parser::Expression> expr);
+                          const Value& object) const;
+  void checkNumberOperands(const lox::parser::Token& token, const Value& left,
+                           const Value& right) const;
+  // Boxes the variable of `binding` into a fresh cell if closures capture
+  // it, ahead of define(), so closures created in between see the variable.
+  void declare(const lox::parser::Binding& binding);
+  void define(const lox::parser::Binding& binding,
+              const lox::parser::Token& name, const Value& value);
+  void checkResolved(const lox::parser::Token& name,
+                     const lox::parser::Binding& binding) const;
+  Value lookupVariable(const lox::parser::Token& name,
+                       const lox::parser::Binding& binding);
 };
 
 }  // namespace lang
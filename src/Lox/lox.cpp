@@ -1,16 +1,20 @@
 #include "lox.h"
 
-#include <folly/File.h>
-#include <folly/FileUtil.h>
+#include <folly/system/MemoryMapping.h>
 
 #include <iostream>
 #include <string_view>
 
 #include "AstPrinter.h"
+#include "HeapProfile.h"
 #include "Interpreter.h"
+#include "LineProfile.h"
+#include "Optimizer.h"
 #include "Parser.h"
+#include "Profiler.h"
 #include "Resolver.h"
 #include "Scanner.h"
+#include "VM.h"
 
 constexpr std::string_view kLoxInputPrompt = "[In]: ";
 constexpr std::string_view kLoxOutputPrompt = "[Out]: ";
@@ -21,11 +25,78 @@ namespace lang {
 bool Lox::hadError = false;
 bool Lox::hadRuntimeError = false;
 
+Lox::Lox(Engine engine)
+    : engine_(engine),
+      interpreter_(std::make_shared<Interpreter>()),
+      resolver_(std::make_unique<Resolver>(interpreter_)) {
+  if (engine_ == Engine::Bytecode) {
+    vm_ = std::make_unique<lox::vm::VM>();
+  }
+}
+
+Lox::~Lox() { stopHeapProfile(); }
+
+void Lox::setMaxCallDepth(int depth) { interpreter_->setMaxCallDepth(depth); }
+
+void Lox::setJitThreshold(uint32_t threshold) {
+  interpreter_->setJitThreshold(threshold);
+}
+
+void Lox::startProfiling(int frequency) {
+  profiler_ = std::make_unique<Profiler>(frequency);
+  interpreter_->setProfiler(profiler_.get());
+  profiler_->start();
+}
+
+void Lox::writeProfile(std::ostream& out) {
+  if (!profiler_) {
+    return;
+  }
+  profiler_->stop();
+  interpreter_->setProfiler(nullptr);
+  profiler_->write(out);
+  profiler_.reset();
+}
+
+void Lox::startLineProfile() {
+  lineProfile_ = std::make_unique<LineProfile>();
+  interpreter_->setLineProfile(lineProfile_.get());
+}
+
+void Lox::writeLineProfile(std::ostream& out, size_t count) {
+  if (!lineProfile_) {
+    return;
+  }
+  interpreter_->setLineProfile(nullptr);
+  lineProfile_->report(out, count);
+  lineProfile_.reset();
+}
+
+void Lox::startHeapProfile(std::ostream& out, int interval) {
+  stopHeapProfile();
+  heapProfile_ = std::make_unique<HeapProfile>(out, interval);
+  heap().setProfile(heapProfile_.get());
+  interpreter_->setHeapProfile(heapProfile_.get());
+}
+
+void Lox::stopHeapProfile() {
+  if (!heapProfile_) {
+    return;
+  }
+  heap().setProfile(nullptr);
+  interpreter_->setHeapProfile(nullptr);
+  heapProfile_->snapshot(heap(), "exit");
+  heapProfile_.reset();
+}
+
 void Lox::runFromFile(const std::string& path) {
-  auto f = folly::File(path);
-  std::string code;
-  folly::readFile(f.fd(), code);
-  run(code);
+  // The script is mapped instead of read, the mapping is owned by the arena
+  // and tokens view straight into it.
+  auto arena = std::make_unique<lox::parser::Arena>();
+  auto bytes = arena->make<folly::MemoryMapping>(path.c_str())->range();
+  auto source = std::string_view(reinterpret_cast<const char*>(bytes.data()),
+                                 bytes.size());
+  runSource(std::move(arena), source);
 }
 
 bool isCompleteStatement(const std::vector<lox::parser::Token>& tokens) {
@@ -47,10 +118,8 @@ bool isCompleteStatement(const std::vector<lox::parser::Token>& tokens) {
 }
 
 void Lox::runPrompt() {
-  auto printer = std::make_unique<lox::parser::AstPrinter>();
-  auto interpreter = std::make_shared<lox::lang::Interpreter>();
-  auto resolver = std::make_unique<lox::lang::Resolver>(interpreter);
   std::vector<lox::parser::Token> tokens;
+  std::unique_ptr<lox::parser::Arena> arena;
 
   for (std::string line;; std::getline(std::cin, line)) {
     hadError = false;
@@ -60,7 +129,13 @@ void Lox::runPrompt() {
     }
 
     if (!line.empty()) {
-      auto scanner = lox::parser::Scanner(line);
+      if (tokens.empty()) {
+        arena = std::make_unique<lox::parser::Arena>();
+      }
+      // Tokens of an unfinished statement view into the previous lines, so
+      // every line is kept in the arena together with the tree.
+      auto scanner =
+          lox::parser::Scanner(*arena->make<std::string>(std::move(line)));
       if (!tokens.empty()) {
         tokens.pop_back();
       }
@@ -76,7 +151,7 @@ void Lox::runPrompt() {
         continue;
       }
 
-      auto parser = lox::parser::Parser(tokens);
+      auto parser = lox::parser::Parser(tokens, *arena);
       auto statements = parser.parse();
 
       if (hadError) {
@@ -86,14 +161,15 @@ void Lox::runPrompt() {
       };
 
       try {
-        resolver->resolve(statements);
+        resolver_->resolve(statements);
         if (hadError) {
           tokens.clear();
           std::cout << kLoxInputPrompt;
           continue;
         }
+        Optimizer(*arena).optimize(statements);
 
-        interpreter->evaluate(statements);
+        execute(std::move(arena), statements);
         tokens.clear();
       } catch (RuntimeError& error) {
         std::cout << "Error: " << error.what();
@@ -109,7 +185,46 @@ void Lox::runPrompt() {
   }
 }
 
-void Lox::run(const std::string& source) {}
+void Lox::run(std::string source) {
+  // Tokens and nodes view into the source, it is owned by the arena so that
+  // it lives exactly as long as the tree.
+  auto arena = std::make_unique<lox::parser::Arena>();
+  std::string_view code = *arena->make<std::string>(std::move(source));
+  runSource(std::move(arena), code);
+}
+
+void Lox::runSource(std::unique_ptr<lox::parser::Arena> arena,
+                    std::string_view source) {
+  hadError = false;
+
+  // The parser pulls tokens from the scanner one at a time.
+  auto scanner = lox::parser::Scanner(source);
+  auto parser = lox::parser::Parser(scanner, *arena);
+  auto statements = parser.parse();
+  if (hadError) {
+    return;
+  }
+
+  resolver_->resolve(statements);
+  if (hadError) {
+    return;
+  }
+  Optimizer(*arena).optimize(statements);
+
+  execute(std::move(arena), statements);
+}
+
+void Lox::execute(std::unique_ptr<lox::parser::Arena> arena,
+                  const std::vector<lox::parser::Statement*>& statements) {
+  if (engine_ == Engine::Bytecode) {
+    vm_->interpret(statements);
+    return;
+  }
+  // Functions and classes created by the interpreter point into the tree,
+  // so it has to live as long as the interpreter, even if execution fails.
+  arenas_.push_back(std::move(arena));
+  interpreter_->evaluate(statements);
+}
 
 }  // namespace lang
 }  // namespace lox
\ No newline at end of file
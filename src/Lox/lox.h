@@ -1,37 +1,103 @@
 #pragma once
-#include <any>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
+#include "LoxString.h"
 #include "RuntimeError.h"
 #include "Token.h"
+#include "Value.h"
 
 namespace lox {
+namespace parser {
+class Arena;
+struct Statement;
+}  // namespace parser
+
+namespace vm {
+class VM;
+}  // namespace vm
+
 namespace lang {
 
+class HeapProfile;
+class Interpreter;
+class LineProfile;
+class Profiler;
+class Resolver;
+
+// Backend that executes resolved programs.
+enum class Engine {
+  // Walks the syntax tree directly.
+  TreeWalker,
+  // Compiles every statement to bytecode and runs it on lox::vm::VM.
+  Bytecode,
+};
+
 class Lox {
  public:
-  Lox() {}
-  ~Lox() {}
+  explicit Lox(Engine engine = Engine::TreeWalker);
+  ~Lox();
 
   void runFromFile(const std::string& path);
   void runPrompt();
-  void run(const std::string& code);
+  void run(std::string code);
+
+  // Deepest call nesting of the tree walker before it reports a stack
+  // overflow. The VM has a fixed number of frames, vm::kFramesMax.
+  void setMaxCallDepth(int depth);
+  // Calls after which the tree walker compiles a function to native code,
+  // 0 disables the JIT.
+  void setJitThreshold(uint32_t threshold);
+  // Samples the Lox call stack of the tree walker `frequency` times per
+  // second of CPU time, until writeProfile().
+  void startProfiling(int frequency);
+  // Stops profiling and writes the samples as collapsed stacks, the input
+  // of flamegraph.pl and speedscope.
+  void writeProfile(std::ostream& out);
+  // Counts executions and time of the statements and calls of every line
+  // the tree walker runs, until writeLineProfile().
+  void startLineProfile();
+  // Stops counting and prints the `count` lines that took longest.
+  void writeLineProfile(std::ostream& out, size_t count);
+  // Counts allocations per kind of object and per line and writes a
+  // snapshot to `out` after every `interval` collections, until
+  // stopHeapProfile(), which writes the last one.
+  void startHeapProfile(std::ostream& out, int interval);
+  void stopHeapProfile();
 
   static void error(int line, const std::string& message) {
     report(line, "", message);
   }
 
   static void error(const lox::parser::Token& tok, const std::string& message) {
-    report(tok.line, " at token " + tok.lexeme, message);
+    report(tok.line, " at token " + std::string(tok.lexeme), message);
   }
 
   static void runtime_error(lox::lang::RuntimeError& error) {
-    report(error.token.line, "at token " + error.token.lexeme, error.what());
+    report(error.token.line, "at token " + std::string(error.token.lexeme),
+           error.what());
     hadRuntimeError = true;
   }
 
  private:
+  const Engine engine_;
+  std::shared_ptr<Interpreter> interpreter_;
+  std::unique_ptr<Resolver> resolver_;
+  std::unique_ptr<lox::vm::VM> vm_;
+  std::unique_ptr<Profiler> profiler_;
+  std::unique_ptr<LineProfile> lineProfile_;
+  std::unique_ptr<HeapProfile> heapProfile_;
+  std::vector<std::unique_ptr<lox::parser::Arena>> arenas_;
+
+  // Scans, parses and executes `source`, which has to be owned by `arena`.
+  void runSource(std::unique_ptr<lox::parser::Arena> arena,
+                 std::string_view source);
+  void execute(std::unique_ptr<lox::parser::Arena> arena,
+               const std::vector<lox::parser::Statement*>& statements);
+
   static bool hadError;
   static bool hadRuntimeError;
 
@@ -42,23 +108,18 @@ class Lox {
     hadError = true;
   }
 
-  static std::string print_output(const std::any& object) {
-    auto& object_type = object.type();
-
-    if (!object.has_value()) {
-      return "nil";
-    }
-    if (object_type == typeid(nullptr)) {
+  static std::string print_output(const Value& object) {
+    if (object.isNil()) {
       return "nil";
     }
-    if (object_type == typeid(std::string)) {
-      return "\"" + std::any_cast<std::string>(object) + "\"";
+    if (object.isString()) {
+      return "\"" + object.as<LoxString>()->value() + "\"";
     }
-    if (object_type == typeid(bool)) {
-      return std::any_cast<bool>(object) ? "true" : "false";
+    if (object.isBool()) {
+      return object.asBool() ? "true" : "false";
     }
-    if (object_type == typeid(double)) {
-      return std::to_string(std::any_cast<double>(object));
+    if (object.isNumber()) {
+      return std::to_string(object.asNumber());
     }
     return "nil";
   }
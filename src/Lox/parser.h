@@ -1,11 +1,14 @@
 #pragma once
 
+#include <charconv>
+#include <string>
 #include <string_view>
 #include <vector>
 
-#include "ControlException.h"
 #include "Expression.h"
+#include "LoxString.h"
 #include "ParseError.h"
+#include "Scanner.h"
 #include "Statement.h"
 #include "Token.h"
 #include "lox.h"
@@ -27,10 +30,32 @@ namespace parser {
 
 class Parser {
  public:
-  Parser(std::vector<Token> tokens) : tokens_(tokens), current_(0) {}
-
-  std::vector<std::shared_ptr<Statement>> parse() {
-    std::vector<std::shared_ptr<Statement>> statements;
+  // Nodes are allocated in `arena`, which has to outlive the returned tree.
+  // `tokens` is borrowed for the duration of parse().
+  Parser(const std::vector<Token>& tokens, Arena& arena)
+      : scanner_(nullptr),
+        tokens_(&tokens),
+        next_(0),
+        previous_(TT::END, 0),
+        current_(TT::END, 0),
+        arena_(arena) {
+    current_ = nextToken();
+  }
+
+  // Pulls tokens from `scanner` as parsing goes, so the token stream is
+  // never materialized.
+  Parser(Scanner& scanner, Arena& arena)
+      : scanner_(&scanner),
+        tokens_(nullptr),
+        next_(0),
+        previous_(TT::END, 0),
+        current_(TT::END, 0),
+        arena_(arena) {
+    current_ = nextToken();
+  }
+
+  std::vector<Statement*> parse() {
+    std::vector<Statement*> statements;
     while (!isAtEnd()) {
       statements.push_back(declaration());
     }
@@ -38,16 +63,17 @@ class Parser {
   }
 
  private:
-  std::shared_ptr<Statement> declaration(bool inLoop = false) {
+  Statement* declaration(bool inLoop = false) {
+    int line = peek().line;
     try {
       if (match({TT::CLASS})) {
-        return classDeclaration();
+        return at(line, classDeclaration());
       }
       if (match({TT::FUN})) {
-        return funcDeclaration();
+        return at(line, funcDeclaration());
       }
       if (match({TT::VAR})) {
-        return varDeclaration();
+        return at(line, varDeclaration());
       }
       return statement(inLoop);
     } catch (ParseError& error) {
@@ -56,35 +82,36 @@ class Parser {
     }
   }
 
-  std::shared_ptr<Statement> classDeclaration() {
+  Statement* classDeclaration() {
     Token name = consume(TT::IDENTIFIER, kExpectIdentifier);
-    std::shared_ptr<Variable> superclass = nullptr;
+    Variable* superclass = nullptr;
     if (match({TT::LESS})) {
       consume(TT::IDENTIFIER, kExpectIdentifier);
-      superclass = std::make_shared<Variable>(previous());
+      superclass = arena_.make<Variable>(previous());
     }
 
     consume(TT::LEFT_BRACE, kExpectLeftBrace);
 
-    std::vector<std::shared_ptr<Function>> methods = {};
+    std::vector<Function*> methods = {};
     while (!check(TT::RIGHT_BRACE)) {
       methods.push_back(funcDeclaration());
     }
     consume(TT::RIGHT_BRACE, kExpectRightBrace);
-    return std::make_shared<Class>(name, superclass, std::move(methods));
+    return arena_.make<Class>(name, superclass,
+                              arena_.list(std::move(methods)));
   }
 
-  std::shared_ptr<Statement> varDeclaration() {
+  Statement* varDeclaration() {
     Token name = consume(TT::IDENTIFIER, kExpectIdentifier);
-    std::shared_ptr<Expression> initializer = nullptr;
+    Expression* initializer = nullptr;
     if (match({TT::EQUAL})) {
       initializer = expression();
     }
     consume(TT::SEMICOLON, kExpectSemicolon);
-    return std::make_shared<Var>(name, std::move(initializer));
+    return arena_.make<Var>(name, initializer);
   }
 
-  std::shared_ptr<Function> funcDeclaration() {
+  Function* funcDeclaration() {
     Token name = consume(TT::IDENTIFIER, kExpectIdentifier);
     consume(TT::LEFT_PAREN, kExpectLeftParen);
 
@@ -98,11 +125,24 @@ class Parser {
     }
 
     consume(TT::LEFT_BRACE, kExpectLeftBrace);
-    return std::make_shared<Function>(name, std::move(parameters),
-                                      std::make_shared<Block>(block()));
+    auto body = arena_.make<Block>(block());
+    auto function = arena_.make<Function>(
+        name, arena_.list(std::move(parameters)), body);
+    function->line = name.line;
+    return function;
+  }
+
+  Statement* at(int line, Statement* stmt) {
+    stmt->line = line;
+    return stmt;
   }
 
-  std::shared_ptr<Statement> statement(bool inLoop = false) {
+  Statement* statement(bool inLoop = false) {
+    int line = peek().line;
+    return at(line, unlocatedStatement(inLoop));
+  }
+
+  Statement* unlocatedStatement(bool inLoop) {
     if (match({TT::PRINT})) {
       return printStatement();
     }
@@ -125,74 +165,75 @@ class Parser {
       return breakStatement();
     }
     if (match({TT::LEFT_BRACE})) {
-      return std::make_shared<Block>(block(inLoop));
+      return arena_.make<Block>(block(inLoop));
     }
     return expressionStatement();
   }
 
-  std::shared_ptr<Statement> returnStatement() {
+  Statement* returnStatement() {
     Token op = previous();
-    std::shared_ptr<Expression> value = nullptr;
+    Expression* value = nullptr;
     if (!check({TT::SEMICOLON})) {
       value = sequence();
     }
     consume(TT::SEMICOLON, kExpectSemicolon);
-    return std::make_shared<Return>(op, std::move(value));
+    return arena_.make<Return>(op, value);
   }
-  std::shared_ptr<Statement> continueStatement() {
+  Statement* continueStatement() {
     Token op = previous();
     consume(TT::SEMICOLON, kExpectSemicolon);
-    return std::make_shared<Continue>(op);
+    return arena_.make<Continue>(op);
   }
-  std::shared_ptr<Statement> breakStatement() {
+  Statement* breakStatement() {
     Token op = previous();
     consume(TT::SEMICOLON, kExpectSemicolon);
-    return std::make_shared<Break>(op);
+    return arena_.make<Break>(op);
   }
-  std::shared_ptr<Statement> printStatement() {
+  Statement* printStatement() {
     auto value = sequence();
     consume(TT::SEMICOLON, kExpectSemicolon);
-    return std::make_shared<Print>(std::move(value));
+    return arena_.make<Print>(value);
   }
 
-  std::shared_ptr<Statement> expressionStatement() {
+  Statement* expressionStatement() {
     auto expr = sequence();
     consume(TT::SEMICOLON, kExpectSemicolon);
-    return std::make_shared<StatementExpression>(std::move(expr));
+    return arena_.make<StatementExpression>(expr);
   }
 
-  std::vector<std::shared_ptr<Statement>> block(bool inLoop = false) {
-    std::vector<std::shared_ptr<Statement>> result;
+  Span<Statement*> block(bool inLoop = false) {
+    std::vector<Statement*> result;
     while (!check(TT::RIGHT_BRACE) && !isAtEnd()) {
       result.push_back(declaration(inLoop));
     }
     consume(TT::RIGHT_BRACE, kExpectRightBrace);
-    return result;
+    return arena_.list(std::move(result));
   }
 
-  std::shared_ptr<Statement> ifStatement(bool inLoop = false) {
+  Statement* ifStatement(bool inLoop = false) {
     consume(TT::LEFT_PAREN, kExpectLeftParen);
     auto condition = sequence();
     consume(TT::RIGHT_PAREN, kExpectRightParen);
     auto then = statement(inLoop);
     if (match({TT::ELSE})) {
-      return std::make_shared<If>(std::move(condition), std::move(then),
+      return arena_.make<If>(condition, then,
                                   statement(inLoop));
     }
-    return std::make_shared<If>(std::move(condition), std::move(then));
+    return arena_.make<If>(condition, then);
   }
 
-  std::shared_ptr<Statement> whileStatement() {
+  Statement* whileStatement() {
     consume(TT::LEFT_PAREN, kExpectLeftParen);
     auto condition = sequence();
     consume(TT::RIGHT_PAREN, kExpectRightParen);
-    return std::make_shared<While>(std::move(condition), statement(true));
+    return arena_.make<While>(condition, statement(true));
   }
 
-  std::shared_ptr<Statement> forStatement() {
+  Statement* forStatement() {
+    int line = previous().line;
     consume(TT::LEFT_PAREN, kExpectLeftParen);
 
-    std::shared_ptr<Statement> initializer;
+    Statement* initializer;
     if (match({TT::SEMICOLON})) {
       initializer = nullptr;
     } else if (match({TT::VAR})) {
@@ -201,53 +242,53 @@ class Parser {
       initializer = expressionStatement();
     }
 
-    std::shared_ptr<Expression> condition = nullptr;
+    Expression* condition = nullptr;
     if (!check({TT::SEMICOLON})) {
       condition = sequence();
     } else {
-      condition = std::make_shared<Literal>(true);
+      condition = arena_.make<Literal>(true);
     }
     consume(TT::SEMICOLON, kExpectSemicolon);
 
-    std::shared_ptr<Expression> increment = nullptr;
+    Expression* increment = nullptr;
     if (!check({TT::RIGHT_PAREN})) {
       increment = sequence();
     }
     consume(TT::RIGHT_PAREN, kExpectRightParen);
 
+    // The statements of the desugared loop belong to the line of the `for`.
     auto body = statement(true);
     if (increment) {
-      body = std::make_shared<Block>(std::vector<std::shared_ptr<Statement>>{
-          std::move(body),
-          std::make_shared<StatementExpression>(std::move(increment))});
+      auto step = at(line, arena_.make<StatementExpression>(increment));
+      body = at(line, arena_.make<Block>(
+                          arena_.list(std::vector<Statement*>{body, step})));
     }
-    body = std::make_shared<While>(std::move(condition), std::move(body));
+    body = at(line, arena_.make<While>(condition, body));
 
     if (initializer) {
-      body = std::make_shared<Block>(std::vector<std::shared_ptr<Statement>>{
-          std::move(initializer), std::move(body)});
+      body = at(line, arena_.make<Block>(arena_.list(
+                          std::vector<Statement*>{initializer, body})));
     }
     return body;
   }
 
-  std::shared_ptr<Expression> sequence() {
-    auto sequence = std::make_shared<Sequence>();
-    sequence->expressions.push_back(expression());
+  Expression* sequence() {
+    std::vector<Expression*> expressions;
+    expressions.push_back(expression());
     while (match({TT::COMMA})) {
-      auto expr = expression();
-      sequence->expressions.push_back(std::move(expr));
+      expressions.push_back(expression());
     }
-    return sequence;
+    return arena_.make<Sequence>(arena_.list(std::move(expressions)));
   }
 
-  std::shared_ptr<Expression> expression() {
+  Expression* expression() {
     if (match({TT::LAMBDA})) {
       return lambda();
     }
     return assignment();
   }
 
-  std::shared_ptr<Expression> lambda() {
+  Expression* lambda() {
     Token token = previous();
     consume(TT::LEFT_PAREN, kExpectLeftParen);
     std::vector<Token> parameters;
@@ -260,10 +301,11 @@ class Parser {
     }
 
     consume(TT::LEFT_BRACE, kExpectLeftBrace);
-    return std::make_shared<Lambda>(std::make_shared<Function>(
-        token, std::move(parameters), std::make_shared<Block>(block())));
+    auto body = arena_.make<Block>(block());
+    return arena_.make<Lambda>(arena_.make<Function>(
+        token, arena_.list(std::move(parameters)), body));
   }
-  std::shared_ptr<Expression> assignment() {
+  Expression* assignment() {
     auto expr = logical_or();
 
     if (match({TT::EQUAL, TT::PLUS_EQUAL, TT::MINUS_EQUAL, TT::STAR_EQUAL,
@@ -289,123 +331,122 @@ class Parser {
           default:
             error(equal, kUnexpectedTokenType);
         }
-        value = std::make_shared<Binary>(expr, Token(type, equal.line),
-                                         std::make_shared<Literal>(1.0));
+        value = arena_.make<Binary>(expr, Token(type, equal.line),
+                                         arena_.make<Literal>(1.0));
       }
 
-      if (Variable* e = dynamic_cast<Variable*>(expr.get())) {
+      if (Variable* e = dynamic_cast<Variable*>(expr)) {
         Token name = e->token;
-        return std::make_shared<Assignment>(std::move(name), std::move(value));
-      } else if (Get* get = dynamic_cast<Get*>(expr.get())) {
-        return std::make_shared<Set>(get->object, get->name, std::move(value));
+        return arena_.make<Assignment>(std::move(name), value);
+      } else if (Get* get = dynamic_cast<Get*>(expr)) {
+        return arena_.make<Set>(get->object, get->name, value);
       }
       error(equal, kExpectExpression);
     }
     if (match({TT::QUESTION})) {
-      return ternary(std::move(expr));
+      return ternary(expr);
     }
 
     return expr;
   }
 
-  std::shared_ptr<Expression> ternary(std::shared_ptr<Expression> predicate) {
+  Expression* ternary(Expression* predicate) {
     auto then = expression();
     if (match({TT::COLON})) {
-      return std::make_shared<Ternary>(std::move(predicate), std::move(then),
+      return arena_.make<Ternary>(predicate, then,
                                        expression());
     }
-    return std::make_shared<Ternary>(std::move(predicate), std::move(then));
+    return arena_.make<Ternary>(predicate, then);
   }
 
-  std::shared_ptr<Expression> logical_or() {
+  Expression* logical_or() {
     auto expr = logical_and();
     if (match({TT::OR})) {
       Token op = previous();
-      expr = std::make_shared<Binary>(std::move(expr), op, logical_and());
+      expr = arena_.make<Binary>(expr, op, logical_and());
     }
     return expr;
   }
 
-  std::shared_ptr<Expression> logical_and() {
+  Expression* logical_and() {
     auto expr = equality();
     if (match({TT::AND})) {
       Token op = previous();
-      expr = std::make_shared<Binary>(std::move(expr), op, equality());
+      expr = arena_.make<Binary>(expr, op, equality());
     }
     return expr;
   }
 
-  std::shared_ptr<Expression> equality() {
+  Expression* equality() {
     auto expr = comparison();
     while (match({TT::BANG_EQUAL, TT::EQUAL_EQUAL})) {
       Token op = previous();
       auto right = comparison();
-      expr = std::make_shared<Binary>(std::move(expr), op, std::move(right));
+      expr = arena_.make<Binary>(expr, op, right);
     }
     return expr;
   }
 
-  std::shared_ptr<Expression> comparison() {
+  Expression* comparison() {
     auto expr = term();
     while (match({TT::GREATER, TT::GREATER_EQUAL, TT::LESS, TT::LESS_EQUAL})) {
       Token op = previous();
       auto right = term();
-      expr = std::make_shared<Binary>(std::move(expr), op, std::move(right));
+      expr = arena_.make<Binary>(expr, op, right);
     }
     return expr;
   }
 
-  std::shared_ptr<Expression> term() {
+  Expression* term() {
     auto expr = factor();
     while (match({TT::MINUS, TT::PLUS})) {
       Token op = previous();
       auto right = factor();
-      expr = std::make_shared<Binary>(std::move(expr), op, std::move(right));
+      expr = arena_.make<Binary>(expr, op, right);
     }
     return expr;
   }
 
-  std::shared_ptr<Expression> factor() {
+  Expression* factor() {
     auto expr = unary();
 
     while (match({TT::SLASH, TT::STAR})) {
       Token op = previous();
       auto right = unary();
-      expr = std::make_shared<Binary>(std::move(expr), op, std::move(right));
+      expr = arena_.make<Binary>(expr, op, right);
     }
     return expr;
   }
 
-  std::shared_ptr<Expression> unary() {
+  Expression* unary() {
     if (match({TT::BANG, TT::MINUS})) {
       Token op = previous();
       auto right = unary();
-      return std::make_shared<Unary>(op, std::move(right));
+      return arena_.make<Unary>(op, right);
     }
     // Prefix increment/decrement
     if (match({TT::PLUS_PLUS, TT::MINUS_MINUS})) {
       Token op = previous();
       auto right = unary();
-      return std::make_shared<Unary>(op, std::move(right));
+      return arena_.make<Unary>(op, right);
     }
     return call();
   }
 
-  std::shared_ptr<Expression> finishCall(
-      const std::shared_ptr<Expression>& callee) {
+  Expression* finishCall(Expression* callee) {
     auto args = arguments();
     consume(TT::RIGHT_PAREN, "Expect ')' after arguments.");
-    return std::make_shared<Call>(callee, previous(), std::move(args));
+    return arena_.make<Call>(callee, previous(), args);
   }
 
-  std::shared_ptr<Expression> call() {
+  Expression* call() {
     auto expr = primary();
     while (true) {
       if (match({TT::LEFT_PAREN})) {
-        expr = finishCall(std::move(expr));
+        expr = finishCall(expr);
       } else if (match({TT::DOT})) {
         Token name = consume(TT::IDENTIFIER, kExpectIdentifier);
-        expr = std::make_shared<Get>(std::move(expr), std::move(name));
+        expr = arena_.make<Get>(expr, std::move(name));
       } else {
         break;
       }
@@ -413,55 +454,56 @@ class Parser {
     return expr;
   }
 
-  std::shared_ptr<Expression> arguments() {
+  Expression* arguments() {
     if (check({TT::RIGHT_PAREN})) {
       return nullptr;
     }
     return sequence();
   }
 
-  std::shared_ptr<Expression> primary() {
+  Expression* primary() {
     if (match({TT::SUPER})) {
       Token keyword = previous();
       consume(TT::DOT, "Expect '.' after super.");
       Token method = consume(TT::IDENTIFIER, "Expect superclass method name.");
-      return std::make_shared<Super>(std::move(keyword), std::move(method));
+      return arena_.make<Super>(std::move(keyword), std::move(method));
     }
     if (match({TT::THIS})) {
-      return std::make_shared<This>(previous());
+      return arena_.make<This>(previous());
     }
     if (match({TT::FALSE})) {
-      return std::make_shared<Literal>(false);
+      return arena_.make<Literal>(false);
     }
     if (match({TT::TRUE})) {
-      return std::make_shared<Literal>(true);
+      return arena_.make<Literal>(true);
     }
     if (match({TT::NIL})) {
-      return std::make_shared<Literal>(nullptr);
+      return arena_.make<Literal>(nullptr);
     }
     if (match({TT::IDENTIFIER})) {
-      auto identifier = std::make_shared<Variable>(previous());
+      auto identifier = arena_.make<Variable>(previous());
       if (match({TT::MINUS_MINUS, TT::PLUS_PLUS})) {
         Token op = previous();
-        return std::make_shared<Unary>(op, std::move(identifier));
+        return arena_.make<Unary>(op, identifier);
       }
       return identifier;
     }
     if (match({TT::NUMBER})) {
-      auto number = std::make_shared<Literal>(atof(previous().lexeme.c_str()));
+      auto number = arena_.make<Literal>(parseNumber(previous().lexeme));
       if (match({TT::MINUS_MINUS, TT::PLUS_PLUS})) {
         Token op = previous();
-        return std::make_shared<Unary>(op, std::move(number));
+        return arena_.make<Unary>(op, number);
       }
       return number;
     }
     if (match({TT::STRING})) {
-      return std::make_shared<Literal>(previous().lexeme);
+      return arena_.make<Literal>(
+          lox::lang::strings().intern(previous().lexeme));
     }
     if (match({TT::LEFT_PAREN})) {
       auto expr = expression();
       consume(TT::RIGHT_PAREN, kExpectRightParen);
-      return std::make_shared<Grouping>(std::move(expr));
+      return arena_.make<Grouping>(expr);
     }
     error(peek(), kExpectExpression);
     return nullptr;
@@ -494,15 +536,25 @@ class Parser {
   }
 
   const Token& advance() {
-    if (!isAtEnd()) current_++;
+    if (!isAtEnd()) {
+      previous_ = current_;
+      current_ = nextToken();
+    }
     return previous();
   }
 
   bool isAtEnd() const { return peek().type == Token::TokenType::END; }
 
-  const Token& peek() const { return tokens_[current_]; }
+  const Token& peek() const { return current_; }
+
+  const Token& previous() const { return previous_; }
 
-  const Token& previous() const { return tokens_[current_ - 1]; }
+  Token nextToken() {
+    if (scanner_) {
+      return scanner_->scanToken();
+    }
+    return (*tokens_)[next_++];
+  }
 
   void synchronize() {
     advance();
@@ -529,8 +581,18 @@ class Parser {
     throw ParseError(std::string(message));
   }
 
-  std::vector<Token> tokens_;
-  int current_;
+  static double parseNumber(std::string_view lexeme) {
+    double value = 0;
+    std::from_chars(lexeme.data(), lexeme.data() + lexeme.size(), value);
+    return value;
+  }
+
+  Scanner* const scanner_;
+  const std::vector<Token>* const tokens_;
+  size_t next_;
+  Token previous_;
+  Token current_;
+  Arena& arena_;
 };
 
 }  // namespace parser
@@ -1,63 +1,54 @@
 #pragma once
 #include <sstream>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
+#include "Symbols.h"
 #include "Token.h"
 #include "lox.h"
 
 namespace lox {
 namespace parser {
 
-const std::unordered_map<std::string, Token::TokenType> keywords = {
-    {"and", Token::TokenType::AND},
-    {"class", Token::TokenType::CLASS},
-    {"else", Token::TokenType::ELSE},
-    {"false", Token::TokenType::FALSE},
-    {"fun", Token::TokenType::FUN},
-    {"for", Token::TokenType::FOR},
-    {"if", Token::TokenType::IF},
-    {"nil", Token::TokenType::NIL},
-    {"or", Token::TokenType::OR},
-    {"print", Token::TokenType::PRINT},
-    {"return", Token::TokenType::RETURN},
-    {"super", Token::TokenType::SUPER},
-    {"this", Token::TokenType::THIS},
-    {"true", Token::TokenType::TRUE},
-    {"var", Token::TokenType::VAR},
-    {"while", Token::TokenType::WHILE},
-    {"break", Token::TokenType::BREAK},
-    {"continue", Token::TokenType::CONTINUE},
-    {"lambda", Token::TokenType::LAMBDA},
-};
-
+// Tokens view into `source` instead of copying it, the caller keeps the
+// buffer alive for as long as the tokens and the tree built from them.
 class Scanner {
  public:
-  Scanner(const std::string& source)
+  Scanner(std::string_view source)
       : source_(source), line_(1), current_pos_(0){};
+
+  // Scans the whole source at once.
   std::vector<Token> scanTokens() {
     std::vector<Token> result;
+    do {
+      result.push_back(scanToken());
+    } while (result.back().type != Token::TokenType::END);
+    return result;
+  }
+
+  // Scans the next token on demand, END once the source is exhausted.
+  Token scanToken() {
     while (const char c = peek()) {
       // Single character tokens
       if (match('(')) {
-        result.push_back(Token(Token::TokenType::LEFT_PAREN, "(", line_));
+        return Token(Token::TokenType::LEFT_PAREN, "(", line_);
       } else if (match(')')) {
-        result.push_back(Token(Token::TokenType::RIGHT_PAREN, ")", line_));
+        return Token(Token::TokenType::RIGHT_PAREN, ")", line_);
       } else if (match('{')) {
-        result.push_back(Token(Token::TokenType::LEFT_BRACE, "{", line_));
+        return Token(Token::TokenType::LEFT_BRACE, "{", line_);
       } else if (match('}')) {
-        result.push_back(Token(Token::TokenType::RIGHT_BRACE, "}", line_));
+        return Token(Token::TokenType::RIGHT_BRACE, "}", line_);
       } else if (match(',')) {
-        result.push_back(Token(Token::TokenType::COMMA, ",", line_));
+        return Token(Token::TokenType::COMMA, ",", line_);
       } else if (match('.')) {
-        result.push_back(Token(Token::TokenType::DOT, ".", line_));
+        return Token(Token::TokenType::DOT, ".", line_);
       } else if (match('?')) {
-        result.push_back(Token(Token::TokenType::QUESTION, "?", line_));
+        return Token(Token::TokenType::QUESTION, "?", line_);
       } else if (match(':')) {
-        result.push_back(Token(Token::TokenType::COLON, ":", line_));
+        return Token(Token::TokenType::COLON, ":", line_);
       } else if (match(';')) {
-        result.push_back(Token(Token::TokenType::SEMICOLON, ";", line_));
+        return Token(Token::TokenType::SEMICOLON, ";", line_);
       } else if (match('\n')) {
         line_++;
       } else if (match(' ') || match('\t') || match('\r') || match('\0')) {
@@ -65,19 +56,19 @@ class Scanner {
         // Single and Double character tokens
       } else if (match('-')) {
         if (match('-')) {
-          result.push_back(Token(Token::TokenType::MINUS_MINUS, "--", line_));
+          return Token(Token::TokenType::MINUS_MINUS, "--", line_);
         } else if (match('=')) {
-          result.push_back(Token(Token::TokenType::MINUS_EQUAL, "-=", line_));
+          return Token(Token::TokenType::MINUS_EQUAL, "-=", line_);
         } else {
-          result.push_back(Token(Token::TokenType::MINUS, "+", line_));
+          return Token(Token::TokenType::MINUS, "+", line_);
         }
       } else if (match('+')) {
         if (match('+')) {
-          result.push_back(Token(Token::TokenType::PLUS_PLUS, "++", line_));
+          return Token(Token::TokenType::PLUS_PLUS, "++", line_);
         } else if (match('=')) {
-          result.push_back(Token(Token::TokenType::PLUS_EQUAL, "+=", line_));
+          return Token(Token::TokenType::PLUS_EQUAL, "+=", line_);
         } else {
-          result.push_back(Token(Token::TokenType::PLUS, "+", line_));
+          return Token(Token::TokenType::PLUS, "+", line_);
         }
       } else if (match('/')) {
         if (match('*')) {
@@ -85,61 +76,60 @@ class Scanner {
         } else if (match('/')) {
           singleLineComment();
         } else if (match('=')) {
-          result.push_back(Token(Token::TokenType::SLASH_EQUAL, "/=", line_));
+          return Token(Token::TokenType::SLASH_EQUAL, "/=", line_);
         } else {
-          result.push_back(Token(Token::TokenType::SLASH, "/", line_));
+          return Token(Token::TokenType::SLASH, "/", line_);
         }
       } else if (match('*')) {
         if (match('=')) {
-          result.push_back(Token(Token::TokenType::STAR_EQUAL, "*=", line_));
+          return Token(Token::TokenType::STAR_EQUAL, "*=", line_);
         } else {
-          result.push_back(Token(Token::TokenType::STAR, "*", line_));
+          return Token(Token::TokenType::STAR, "*", line_);
         }
       } else if (match('!')) {
         if (match('=')) {
-          result.push_back(Token(Token::TokenType::BANG_EQUAL, "!=", line_));
+          return Token(Token::TokenType::BANG_EQUAL, "!=", line_);
 
         } else {
-          result.push_back(Token(Token::TokenType::BANG, "!", line_));
+          return Token(Token::TokenType::BANG, "!", line_);
         }
       } else if (match('=')) {
         if (match('=')) {
-          result.push_back(Token(Token::TokenType::EQUAL_EQUAL, "==", line_));
+          return Token(Token::TokenType::EQUAL_EQUAL, "==", line_);
         } else {
-          result.push_back(Token(Token::TokenType::EQUAL, "=", line_));
+          return Token(Token::TokenType::EQUAL, "=", line_);
         }
       } else if (match('>')) {
         if (match('=')) {
-          result.push_back(Token(Token::TokenType::GREATER_EQUAL, ">=", line_));
+          return Token(Token::TokenType::GREATER_EQUAL, ">=", line_);
         } else {
-          result.push_back(Token(Token::TokenType::GREATER, ">", line_));
+          return Token(Token::TokenType::GREATER, ">", line_);
         }
       } else if (match('<')) {
         if (match('=')) {
-          result.push_back(Token(Token::TokenType::LESS_EQUAL, "<=", line_));
+          return Token(Token::TokenType::LESS_EQUAL, "<=", line_);
         } else {
-          result.push_back(Token(Token::TokenType::LESS, "<", line_));
+          return Token(Token::TokenType::LESS, "<", line_);
         }
       } else if (match('"')) {
         // string
-        result.push_back(string());
+        return string();
       } else if (isdigit(c)) {
         // number
-        result.push_back(number());
+        return number();
       } else if (isalpha(c)) {
         // identifiers
-        result.push_back(identifier());
+        return identifier();
       } else {
         lox::lang::Lox::error(line_, "Unknown charracter: " + std::string{c});
         advance();
       }
     }
-    result.push_back(Token(Token::TokenType::END, line_));
-    return result;
+    return Token(Token::TokenType::END, line_);
   }
 
  private:
-  const std::string source_;
+  const std::string_view source_;
   int line_;
   int current_pos_;
 
@@ -210,13 +200,83 @@ class Scanner {
       advance();
     }
     auto identifier = source_.substr(start, current_pos_ - start);
-    Token::TokenType type;
-    try {
-      type = keywords.at(identifier);
-    } catch (std::out_of_range) {
-      type = Token::TokenType::IDENTIFIER;
+    auto type = keywordType(identifier);
+    if (type != Token::TokenType::IDENTIFIER) {
+      return Token(type, identifier, line_);
+    }
+    return Token(type, symbols().intern(identifier), line_);
+  }
+
+  // Keywords are recognized by a trie spelled out as switches over the raw
+  // characters: the first one or two characters select the only candidate
+  // keyword, the rest is a single comparison.
+  static Token::TokenType keywordType(std::string_view text) {
+    switch (text[0]) {
+      case 'a':
+        return checkKeyword(text, 1, "nd", Token::TokenType::AND);
+      case 'b':
+        return checkKeyword(text, 1, "reak", Token::TokenType::BREAK);
+      case 'c':
+        if (text.size() > 1) {
+          switch (text[1]) {
+            case 'l':
+              return checkKeyword(text, 2, "ass", Token::TokenType::CLASS);
+            case 'o':
+              return checkKeyword(text, 2, "ntinue",
+                                  Token::TokenType::CONTINUE);
+          }
+        }
+        break;
+      case 'e':
+        return checkKeyword(text, 1, "lse", Token::TokenType::ELSE);
+      case 'f':
+        if (text.size() > 1) {
+          switch (text[1]) {
+            case 'a':
+              return checkKeyword(text, 2, "lse", Token::TokenType::FALSE);
+            case 'o':
+              return checkKeyword(text, 2, "r", Token::TokenType::FOR);
+            case 'u':
+              return checkKeyword(text, 2, "n", Token::TokenType::FUN);
+          }
+        }
+        break;
+      case 'i':
+        return checkKeyword(text, 1, "f", Token::TokenType::IF);
+      case 'l':
+        return checkKeyword(text, 1, "ambda", Token::TokenType::LAMBDA);
+      case 'n':
+        return checkKeyword(text, 1, "il", Token::TokenType::NIL);
+      case 'o':
+        return checkKeyword(text, 1, "r", Token::TokenType::OR);
+      case 'p':
+        return checkKeyword(text, 1, "rint", Token::TokenType::PRINT);
+      case 'r':
+        return checkKeyword(text, 1, "eturn", Token::TokenType::RETURN);
+      case 's':
+        return checkKeyword(text, 1, "uper", Token::TokenType::SUPER);
+      case 't':
+        if (text.size() > 1) {
+          switch (text[1]) {
+            case 'h':
+              return checkKeyword(text, 2, "is", Token::TokenType::THIS);
+            case 'r':
+              return checkKeyword(text, 2, "ue", Token::TokenType::TRUE);
+          }
+        }
+        break;
+      case 'v':
+        return checkKeyword(text, 1, "ar", Token::TokenType::VAR);
+      case 'w':
+        return checkKeyword(text, 1, "hile", Token::TokenType::WHILE);
     }
-    return Token(type, std::move(identifier), line_);
+    return Token::TokenType::IDENTIFIER;
+  }
+
+  static Token::TokenType checkKeyword(std::string_view text, size_t start,
+                                       std::string_view rest,
+                                       Token::TokenType type) {
+    return text.substr(start) == rest ? type : Token::TokenType::IDENTIFIER;
   }
 
   bool match(const char& c) {
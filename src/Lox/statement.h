@@ -1,9 +1,9 @@
 #pragma once
-#include <any>
 #include <memory>
+#include <vector>
 
-#include "ControlException.h"
 #include "Expression.h"
+#include "Jit.h"
 
 namespace lox {
 namespace parser {
@@ -22,169 +22,171 @@ struct Class;
 
 class StatementVisitor {
  public:
-  virtual std::any visit(std::shared_ptr<const StatementExpression> stmt) = 0;
-  virtual std::any visit(std::shared_ptr<const Print> stmt) = 0;
-  virtual std::any visit(std::shared_ptr<const Var> stmt) = 0;
-  virtual std::any visit(std::shared_ptr<const Block> stmt) = 0;
-  virtual std::any visit(std::shared_ptr<const If> stmt) = 0;
-  virtual std::any visit(std::shared_ptr<const While> stmt) = 0;
-  virtual std::any visit(std::shared_ptr<const Continue> stmt) = 0;
-  virtual std::any visit(std::shared_ptr<const Break> stmt) = 0;
-  virtual std::any visit(std::shared_ptr<const Return> stmt) = 0;
-  virtual std::any visit(std::shared_ptr<const Function> stmt) = 0;
-  virtual std::any visit(std::shared_ptr<const Class> stmt) = 0;
+  virtual lox::lang::Value visit(
+      const StatementExpression* stmt) = 0;
+  virtual lox::lang::Value visit(const Print* stmt) = 0;
+  virtual lox::lang::Value visit(const Var* stmt) = 0;
+  virtual lox::lang::Value visit(const Block* stmt) = 0;
+  virtual lox::lang::Value visit(const If* stmt) = 0;
+  virtual lox::lang::Value visit(const While* stmt) = 0;
+  virtual lox::lang::Value visit(const Continue* stmt) = 0;
+  virtual lox::lang::Value visit(const Break* stmt) = 0;
+  virtual lox::lang::Value visit(const Return* stmt) = 0;
+  virtual lox::lang::Value visit(const Function* stmt) = 0;
+  virtual lox::lang::Value visit(const Class* stmt) = 0;
   virtual ~StatementVisitor() = default;
 };
 
 struct Statement {
-  virtual std::any accept(StatementVisitor* visitor) = 0;
+  virtual lox::lang::Value accept(StatementVisitor* visitor) const = 0;
   virtual ~Statement() = default;
+
+  // Line of the first token of the statement, filled in by the Parser.
+  int line = 0;
 };
 
 struct StatementExpression
-    : Statement,
-      public std::enable_shared_from_this<StatementExpression> {
-  StatementExpression(const std::shared_ptr<Expression>& expression)
-      : expression{std::move(expression)} {}
+    : Statement {
+  StatementExpression(Expression* expression) : expression{expression} {}
 
-  std::any accept(StatementVisitor* visitor) override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(StatementVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
-  const std::shared_ptr<Expression> expression;
+  Expression* const expression;
 };
 
-struct Print : Statement, public std::enable_shared_from_this<Print> {
-  Print(const std::shared_ptr<Expression>& expression)
-      : expression{std::move(expression)} {}
+struct Print : Statement {
+  Print(Expression* expression) : expression{expression} {}
 
-  std::any accept(StatementVisitor* visitor) override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(StatementVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
-  const std::shared_ptr<Expression> expression;
+  Expression* const expression;
 };
 
-struct Var : Statement, public std::enable_shared_from_this<Var> {
-  Var(const Token& token, const std::shared_ptr<Expression>& initializer)
-      : token(token), initializer(std::move(initializer)) {}
+struct Var : Statement {
+  Var(const Token& token, Expression* initializer)
+      : token(token), initializer(initializer) {}
 
-  std::any accept(StatementVisitor* visitor) override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(StatementVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
   const Token token;
-  const std::shared_ptr<Expression> initializer;
+  Expression* const initializer;
+  mutable Binding binding;
 };
 
-struct Block : Statement, public std::enable_shared_from_this<Block> {
-  Block(const std::vector<std::shared_ptr<Statement>>& statements)
-      : statements(std::move(statements)) {}
+struct Block : Statement {
+  Block(Span<Statement*> statements) : statements(statements) {}
 
-  std::any accept(StatementVisitor* visitor) override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(StatementVisitor* visitor) const override {
+    return visitor->visit(this);
   }
-  const std::vector<std::shared_ptr<Statement>> statements;
+  const Span<Statement*> statements;
 };
 
-struct If : public Statement, std::enable_shared_from_this<If> {
-  If(const std::shared_ptr<Expression>& predicate,
-     const std::shared_ptr<Statement>& then)
-      : predicate(std::move(predicate)),
-        then(std::move(then)),
-        alternative(nullptr) {}
-
-  If(const std::shared_ptr<Expression>& predicate,
-     const std::shared_ptr<Statement>& then,
-     const std::shared_ptr<Statement>& alternative)
-      : predicate(std::move(predicate)),
-        then(std::move(then)),
-        alternative(std::move(alternative)) {}
-
-  std::any accept(StatementVisitor* visitor) override {
-    return visitor->visit(shared_from_this());
+struct If : public Statement {
+  If(Expression* predicate, Statement* then)
+      : predicate(predicate), then(then), alternative(nullptr) {}
+
+  If(Expression* predicate, Statement* then, Statement* alternative)
+      : predicate(predicate), then(then), alternative(alternative) {}
+
+  lox::lang::Value accept(StatementVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
-  const std::shared_ptr<Expression> predicate;
-  const std::shared_ptr<Statement> then;
-  const std::shared_ptr<Statement> alternative;
+  Expression* const predicate;
+  Statement* const then;
+  Statement* const alternative;
 };
 
-struct While : public Statement, std::enable_shared_from_this<While> {
-  While(const std::shared_ptr<Expression>& condition,
-        const std::shared_ptr<Statement>& body)
-      : condition(std::move(condition)), body(std::move(body)) {}
+struct While : public Statement {
+  While(Expression* condition, Statement* body)
+      : condition(condition), body(body) {}
 
-  std::any accept(StatementVisitor* visitor) override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(StatementVisitor* visitor) const override {
+    return visitor->visit(this);
   }
-  const std::shared_ptr<Expression> condition;
-  const std::shared_ptr<Statement> body;
+  // nullptr for loops without a condition, which run until they break or
+  // return.
+  Expression* const condition;
+  Statement* const body;
 };
 
-struct Function : public Statement, std::enable_shared_from_this<Function> {
-  Function(const Token& name, const std::vector<Token>& parameters,
-           const std::shared_ptr<Block>& body)
-      : name(name), parameters(std::move(parameters)), body(std::move(body)) {}
-  std::any accept(StatementVisitor* visitor) override {
-    return visitor->visit(shared_from_this());
+struct Function : public Statement {
+  Function(const Token& name, Span<Token> parameters, Block* body)
+      : name(name), parameters(parameters), body(body) {}
+  lox::lang::Value accept(StatementVisitor* visitor) const override {
+    return visitor->visit(this);
   }
   const Token name;
-  const std::vector<Token> parameters;
-  const std::shared_ptr<Block> body;
+  const Span<Token> parameters;
+  Block* const body;
+  // Declaration of the name, for function statements.
+  mutable Binding binding;
+  // Filled in by the Resolver: the size of the call frame, the frame slots
+  // of parameters captured by closures, which are boxed on entry, and what
+  // the closure captures from its enclosing function, in upvalue order.
+  mutable int slots = 0;
+  mutable std::vector<int> boxedParameters;
+  mutable std::vector<Capture> captures;
+  // Invocation count and native code of the function, see lox::lang::Jit.
+  mutable lox::lang::JitState jit;
 };
 
-struct Continue : public Statement, std::enable_shared_from_this<Continue> {
+struct Continue : public Statement {
   explicit Continue(const Token& token) : token(token) {}
 
-  std::any accept(StatementVisitor* visitor) override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(StatementVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
   const Token token;
 };
 
-struct Break : public Statement, std::enable_shared_from_this<Break> {
+struct Break : public Statement {
   explicit Break(const Token& token) : token(token) {}
 
-  std::any accept(StatementVisitor* visitor) override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(StatementVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
   const Token token;
 };
 
-struct Return : public Statement, std::enable_shared_from_this<Return> {
+struct Return : public Statement {
   explicit Return(const Token& token) : token(token), value(nullptr) {}
-  Return(const Token& token, const std::shared_ptr<Expression>& value)
-      : token(token), value(std::move(value)) {}
+  Return(const Token& token, Expression* value) : token(token), value(value) {}
 
-  std::any accept(StatementVisitor* visitor) override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(StatementVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
   const Token token;
-  const std::shared_ptr<Expression> value;
+  Expression* const value;
 };
 
-struct Class : public Statement, std::enable_shared_from_this<Class> {
-  Class(const Token& name,
-        const std::vector<std::shared_ptr<Function>>& methods)
-      : name(name), superclass(nullptr), methods(std::move(methods)) {}
+struct Class : public Statement {
+  Class(const Token& name, Span<Function*> methods)
+      : name(name), superclass(nullptr), methods(methods) {}
 
-  Class(const Token& name, const std::shared_ptr<Variable>& superclass,
-        const std::vector<std::shared_ptr<Function>>& methods)
-      : name(name),
-        superclass(std::move(superclass)),
-        methods(std::move(methods)) {}
+  Class(const Token& name, Variable* superclass, Span<Function*> methods)
+      : name(name), superclass(superclass), methods(methods) {}
 
-  std::any accept(StatementVisitor* visitor) override {
-    return visitor->visit(shared_from_this());
+  lox::lang::Value accept(StatementVisitor* visitor) const override {
+    return visitor->visit(this);
   }
 
   const Token name;
-  const std::shared_ptr<Variable> superclass;
-  const std::vector<std::shared_ptr<Function>> methods;
+  Variable* const superclass;
+  const Span<Function*> methods;
+  mutable Binding binding;
+  // Declaration of "super", the superclass as seen by the methods.
+  mutable Binding superBinding;
 };
 
 }  // namespace parser
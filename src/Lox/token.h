@@ -1,7 +1,7 @@
 #pragma once
 
 #include <iostream>
-#include <string>
+#include <string_view>
 
 namespace lox {
 namespace parser {
@@ -68,13 +68,15 @@ struct Token {
   };
 
   Token(const TokenType type, const int line) : type(type), line(line) {}
-  Token(const TokenType type, const std::string& lexeme, const int line)
+  Token(const TokenType type, std::string_view lexeme, const int line)
       : type(type), lexeme(lexeme), line(line){};
   ~Token() = default;
 
-  const TokenType type;
-  const std::string lexeme;
-  const int line;
+  TokenType type;
+  // Points into the scanned source, or into the symbol table for identifiers
+  // and keywords. The token does not own the characters.
+  std::string_view lexeme;
+  int line;
 };
 
 }  // namespace parser
@@ -1,14 +1,14 @@
 #pragma once
 
-#include <any>
 #include <string>
-#include <type_traits>
+
+#include "Value.h"
 
 namespace lox {
 namespace util {
 
-std::string any_to_string(const std::any& object);
+std::string to_string(const lox::lang::Value& value);
 
 }  // namespace util
 
-}  // namespace lox
\ No newline at end of file
+}  // namespace lox
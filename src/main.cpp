@@ -1,19 +1,101 @@
 #include <gflags/gflags.h>
 
+#include <chrono>
+#include <fstream>
 #include <iostream>
 
+#include "Lox/Heap.h"
+#include "Lox/InlineCache.h"
+#include "Lox/Interpreter.h"
+#include "Lox/Jit.h"
+#include "Lox/Profiler.h"
 #include "Lox/lox.h"
 
 DEFINE_string(file, "", "Script file path");
+DEFINE_bool(vm, false, "Run scripts on the bytecode virtual machine");
+DEFINE_double(gc_growth_factor, lox::lang::Heap::kDefaultGrowthFactor,
+              "Heap growth between garbage collections");
+DEFINE_bool(gc_stats, false, "Print garbage collector statistics on exit");
+DEFINE_int32(max_call_depth, lox::lang::Interpreter::kDefaultMaxCallDepth,
+             "Call nesting of the tree walker that counts as a stack overflow");
+DEFINE_int32(jit_threshold, lox::lang::Jit::kDefaultThreshold,
+             "Calls after which a function is compiled to x86-64 code, 0 "
+             "disables the JIT");
+DEFINE_string(profile, "",
+              "Sample the Lox call stack and write it to this file as "
+              "collapsed stacks, for flamegraph.pl or speedscope");
+DEFINE_int32(profile_frequency, lox::lang::Profiler::kDefaultFrequency,
+             "Samples per second of CPU time taken by --profile");
+DEFINE_bool(line_profile, false,
+            "Count executions and time per source line and print the "
+            "hottest lines on exit");
+DEFINE_int32(line_profile_top, 20, "Lines printed by --line_profile");
+DEFINE_string(heap_profile, "",
+              "Count allocations per kind of object and per line and write "
+              "snapshots of them to this file");
+DEFINE_int32(heap_profile_interval, 1,
+             "Garbage collections between two --heap_profile snapshots");
+DEFINE_bool(ic_stats, false, "Print inline cache hit rates on exit");
 
 int main(int argc, char** argv) {
   gflags::ParseCommandLineFlags(&argc, &argv, true);
+  lox::lang::heap().setGrowthFactor(FLAGS_gc_growth_factor);
 
-  auto lox = lox::lang::Lox();
+  auto lox = lox::lang::Lox(FLAGS_vm ? lox::lang::Engine::Bytecode
+                                     : lox::lang::Engine::TreeWalker);
+  lox.setMaxCallDepth(FLAGS_max_call_depth);
+  lox.setJitThreshold(FLAGS_jit_threshold);
+  if (!FLAGS_profile.empty()) {
+    lox.startProfiling(FLAGS_profile_frequency);
+  }
+  if (FLAGS_line_profile) {
+    lox.startLineProfile();
+  }
+  std::ofstream heapProfile;
+  if (!FLAGS_heap_profile.empty()) {
+    heapProfile.open(FLAGS_heap_profile);
+    lox.startHeapProfile(heapProfile, FLAGS_heap_profile_interval);
+  }
 
   if (!FLAGS_file.empty()) {
     lox.runFromFile(FLAGS_file);
   } else {
     lox.runPrompt();
   }
+
+  if (!FLAGS_profile.empty()) {
+    std::ofstream profile(FLAGS_profile);
+    lox.writeProfile(profile);
+  }
+  if (FLAGS_line_profile) {
+    lox.writeLineProfile(std::cerr, FLAGS_line_profile_top);
+  }
+  lox.stopHeapProfile();
+
+  if (FLAGS_gc_stats) {
+    const auto& stats = lox::lang::heap().stats();
+    std::cerr << "collections: " << stats.collections << "\n"
+              << "objects allocated: " << stats.objectsAllocated << "\n"
+              << "objects freed: " << stats.objectsFreed << "\n"
+              << "bytes allocated: " << stats.bytesAllocated << "\n"
+              << "bytes freed: " << stats.bytesFreed << "\n"
+              << "peak bytes: " << stats.peakBytes << "\n"
+              << "pause time: "
+              << std::chrono::duration<double, std::milli>(stats.pauseTime)
+                     .count()
+              << "ms\n";
+  }
+
+  if (FLAGS_ic_stats) {
+    const auto& stats = lox::lang::inlineCacheStats();
+    auto print = [](const char* kind,
+                    const lox::lang::CacheCounters& counters) {
+      std::cerr << kind << ": " << counters.hits << " hits, "
+                << counters.misses << " misses, " << counters.hitRate() * 100
+                << "% hit rate\n";
+    };
+    print("get", stats.get);
+    print("set", stats.set);
+    print("invoke", stats.invoke);
+  }
 }
\ No newline at end of file
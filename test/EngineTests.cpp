@@ -0,0 +1,276 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+
+#include "../src/Lox/lox.h"
+
+using lox::lang::Engine;
+using lox::lang::Lox;
+
+constexpr std::string_view kArithmetic =
+    "print 1 + 2 * 3 - 4 / 2;\n"
+    "print -(1 + 1);\n"
+    "print 3 > 2 and 2 >= 2;\n"
+    "print !nil;";
+constexpr std::string_view kStrings =
+    "var a = \"foo\";\n"
+    "print a + \"bar\";\n"
+    "print a + 1;\n"
+    "print a == \"foo\";";
+constexpr std::string_view kStringEquality =
+    "var a = \"same\";\n"
+    "var b = \"same\";\n"
+    "print a == b;\n"
+    "print a + \"\" == b;\n"
+    "print b == a + \"\";\n"
+    "print a == \"other\";\n"
+    "print a + 1 == \"same1.000000\";";
+constexpr std::string_view kScopes =
+    "var a = \"global\";\n"
+    "{\n"
+    "  var a = \"outer\";\n"
+    "  { var a = \"inner\"; print a; }\n"
+    "  print a;\n"
+    "}\n"
+    "print a;";
+constexpr std::string_view kLoops =
+    "var sum = 0;\n"
+    "for (var i = 0; i < 10; i = i + 1) {\n"
+    "  if (i == 5) break;\n"
+    "  sum = sum + i;\n"
+    "}\n"
+    "print sum;\n"
+    "var j = 0;\n"
+    "while (j < 3) j = j + 1;\n"
+    "print j;";
+constexpr std::string_view kClosures =
+    "fun counter() {\n"
+    "  var count = 0;\n"
+    "  fun inc() { count = count + 1; return count; }\n"
+    "  return inc;\n"
+    "}\n"
+    "var c = counter();\n"
+    "c();\n"
+    "print c();\n"
+    "fun fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+    "print fib(15);";
+constexpr std::string_view kClasses =
+    "class A {\n"
+    "  init(name) { this.name = name; }\n"
+    "  greet() { return \"A \" + this.name; }\n"
+    "}\n"
+    "class B < A {\n"
+    "  greet() { return \"B \" + super.greet(); }\n"
+    "}\n"
+    "var b = B(\"bob\");\n"
+    "print b.greet();\n"
+    "var g = b.greet;\n"
+    "print g();\n"
+    "print b;\n"
+    "print B;";
+constexpr std::string_view kNestedScopes =
+    "fun outer() {\n"
+    "  var x = \"outer\";\n"
+    "  fun middle() {\n"
+    "    { var y = \"block\"; fun inner() { return x + y; } return inner; }\n"
+    "  }\n"
+    "  return middle();\n"
+    "}\n"
+    "print outer()();\n"
+    "var i = 0;\n"
+    "while (true) { var j = i; { if (j == 2) break; } i = i + 1; }\n"
+    "print i;";
+constexpr std::string_view kCaptures =
+    "var total = 0;\n"
+    "for (var i = 0; i < 3; i = i + 1) {\n"
+    "  var j = i;\n"
+    "  fun get() { return j; }\n"
+    "  j = j * 10;\n"
+    "  total = total + get();\n"
+    "}\n"
+    "print total;\n"
+    "fun adder(x) { return lambda(y) { x = x + y; return x; }; }\n"
+    "var add = adder(1);\n"
+    "add(2);\n"
+    "print add(3);\n"
+    "fun outer(n) {\n"
+    "  fun down(k) { if (k == 0) return n; return down(k - 1); }\n"
+    "  return down(n);\n"
+    "}\n"
+    "print outer(4);";
+constexpr std::string_view kConstants =
+    "var day = 60 * 60 * 24;\n"
+    "print day;\n"
+    "print \"v\" + 1 + \"!\";\n"
+    "if (day > 1000 and true) print \"big\"; else print \"small\";\n"
+    "if (false) print \"dead\";\n"
+    "var n = 0;\n"
+    "for (;;) { n = n + 1; if (n == 3) break; }\n"
+    "print n;\n"
+    "print (1 < 2) ? \"yes\" : \"no\";";
+constexpr std::string_view kNumberFeedback =
+    "fun add(a, b) { return a + b; }\n"
+    "fun below(a) { return a < 10; }\n"
+    "fun half(a, b) { return a / b; }\n"
+    "for (var i = 0; i < 10; i = i + 1) { add(i, i); below(i); half(i, 2); }\n"
+    "print add(1, 2);\n"
+    "print add(\"a\", 1);\n"
+    "print add(2, 3);\n"
+    "print below(3);\n"
+    "print below(nil);\n"
+    "print half(1, 0);\n"
+    "print half(9, 2);";
+constexpr std::string_view kInheritance =
+    "class A {\n"
+    "  init(x) { this.x = x; }\n"
+    "  who() { return \"A\"; }\n"
+    "  value() { return this.x; }\n"
+    "}\n"
+    "class B < A { who() { return \"B\" + super.who(); } }\n"
+    "class C < B {}\n"
+    "class D < C { who() { return \"D\" + super.who(); } }\n"
+    "var d = D(7);\n"
+    "print d.who();\n"
+    "print d.value();\n"
+    "print C(1).who();";
+constexpr std::string_view kControlFlow =
+    "fun find(n) { while (true) { if (n > 3) return n; n = n + 1; } }\n"
+    "print find(0);\n"
+    "var sum = 0;\n"
+    "var i = 0;\n"
+    "while (i < 10) {\n"
+    "  i = i + 1;\n"
+    "  { if (i == 2) continue; }\n"
+    "  if (i == 5) break;\n"
+    "  sum = sum + i;\n"
+    "}\n"
+    "print sum;\n"
+    "fun early() { { { return \"inner\"; } } return \"outer\"; }\n"
+    "print early();";
+constexpr std::string_view kRuntimeErrors =
+    "print 1 + nil;\n"
+    "print \"after\";\n"
+    "print undefined;\n"
+    "fun f(a) {}\n"
+    "f(1, 2);\n"
+    "print 1 / 0;";
+constexpr std::string_view kDeepRecursion =
+    "fun depth(n) { if (n == 0) return 0; return depth(n - 1) + 1; }\n"
+    "print depth(100);\n"
+    "print depth(1000000);\n"
+    "print depth(10);";
+
+class EngineTests : public testing::TestWithParam<Engine> {
+ protected:
+  std::string run(std::string_view code) {
+    auto lox = Lox(GetParam());
+    testing::internal::CaptureStdout();
+    lox.run(std::string{code});
+    return testing::internal::GetCapturedStdout();
+  }
+};
+
+TEST_P(EngineTests, TestArithmetic) {
+  EXPECT_EQ(run(kArithmetic),
+            "[Out]: 5.000000\n[Out]: -2.000000\n[Out]: true\n[Out]: true\n");
+}
+
+TEST_P(EngineTests, TestStrings) {
+  EXPECT_EQ(run(kStrings),
+            "[Out]: foobar\n[Out]: foo1.000000\n[Out]: true\n");
+}
+
+TEST_P(EngineTests, TestStringEquality) {
+  EXPECT_EQ(run(kStringEquality),
+            "[Out]: true\n[Out]: true\n[Out]: true\n[Out]: false\n"
+            "[Out]: true\n");
+}
+
+TEST_P(EngineTests, TestScopes) {
+  EXPECT_EQ(run(kScopes), "[Out]: inner\n[Out]: outer\n[Out]: global\n");
+}
+
+TEST_P(EngineTests, TestLoops) {
+  EXPECT_EQ(run(kLoops), "[Out]: 10.000000\n[Out]: 3.000000\n");
+}
+
+TEST_P(EngineTests, TestClosures) {
+  EXPECT_EQ(run(kClosures), "[Out]: 2.000000\n[Out]: 610.000000\n");
+}
+
+TEST_P(EngineTests, TestNestedScopes) {
+  EXPECT_EQ(run(kNestedScopes), "[Out]: outerblock\n[Out]: 2.000000\n");
+}
+
+TEST_P(EngineTests, TestCaptures) {
+  EXPECT_EQ(run(kCaptures),
+            "[Out]: 30.000000\n[Out]: 6.000000\n[Out]: 4.000000\n");
+}
+
+TEST_P(EngineTests, TestClasses) {
+  EXPECT_EQ(run(kClasses),
+            "[Out]: B A bob\n[Out]: B A bob\n[Out]: Instance of Class B\n"
+            "[Out]: Class B\n");
+}
+
+TEST_P(EngineTests, TestConstants) {
+  EXPECT_EQ(run(kConstants),
+            "[Out]: 86400.000000\n[Out]: v1.000000!\n[Out]: big\n"
+            "[Out]: 3.000000\n[Out]: yes\n");
+}
+
+TEST_P(EngineTests, TestNumberFeedback) {
+  auto output = run(kNumberFeedback);
+  EXPECT_EQ(output.find("[Out]: 3.000000\n[Out]: a1.000000\n[Out]: 5.000000\n"
+                        "[Out]: true\n"),
+            0);
+  EXPECT_NE(output.find("Operands must be numbers."), std::string::npos);
+  EXPECT_NE(output.find("Second operand must be non-zero."),
+            std::string::npos);
+  EXPECT_NE(output.find("[Out]: 4.500000\n"), std::string::npos);
+}
+
+TEST_P(EngineTests, TestInheritance) {
+  EXPECT_EQ(run(kInheritance),
+            "[Out]: DBA\n[Out]: 7.000000\n[Out]: BA\n");
+}
+
+TEST_P(EngineTests, TestControlFlow) {
+  EXPECT_EQ(run(kControlFlow),
+            "[Out]: 4.000000\n[Out]: 8.000000\n[Out]: inner\n");
+}
+
+TEST_P(EngineTests, TestRuntimeErrors) {
+  auto output = run(kRuntimeErrors);
+  EXPECT_NE(output.find("Operands must be either numbers or strings."),
+            std::string::npos);
+  EXPECT_NE(output.find("[Out]: after\n"), std::string::npos);
+  EXPECT_NE(output.find("Undefined variable 'undefined'."), std::string::npos);
+  EXPECT_NE(output.find("Invalid argument number"), std::string::npos);
+  EXPECT_NE(output.find("Second operand must be non-zero."),
+            std::string::npos);
+}
+
+TEST_P(EngineTests, TestStackOverflow) {
+  auto output = run(kDeepRecursion);
+  EXPECT_EQ(output.find("[Out]: 100.000000\n"), 0);
+  EXPECT_NE(output.find("Stack overflow."), std::string::npos);
+  // The error unwinds every frame, later calls start from the bottom.
+  EXPECT_NE(output.find("[Out]: 10.000000\n"), std::string::npos);
+}
+
+TEST(EngineTests, TestMaxCallDepth) {
+  auto lox = Lox(Engine::TreeWalker);
+  lox.setMaxCallDepth(10);
+  testing::internal::CaptureStdout();
+  lox.run("fun depth(n) { if (n == 0) return 0; return depth(n - 1) + 1; }\n"
+          "print depth(9);\n"
+          "print depth(10);");
+  auto output = testing::internal::GetCapturedStdout();
+  EXPECT_EQ(output.find("[Out]: 9.000000\n"), 0);
+  EXPECT_NE(output.find("Stack overflow."), std::string::npos);
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, EngineTests,
+                         testing::Values(Engine::TreeWalker, Engine::Bytecode));
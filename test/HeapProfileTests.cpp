@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+
+#include "../src/Lox/Heap.h"
+#include "../src/Lox/HeapProfile.h"
+#include "../src/Lox/lox.h"
+
+using lox::lang::heap;
+using lox::lang::HeapProfile;
+using lox::lang::Lox;
+
+TEST(HeapProfileTests, TestCountsLiveObjectsPerKindAndLine) {
+  std::ostringstream out;
+  auto lox = Lox();
+  lox.startHeapProfile(out, 1);
+  auto profile = heap().profile();
+  ASSERT_NE(profile, nullptr);
+  auto collections = heap().stats().collections;
+  lox.run(
+      "class Node { init(next) { this.next = next; } }\n"
+      "var kept = nil;\n"
+      "for (var i = 0; i < 10; i = i + 1) kept = Node(kept);\n"
+      "for (var i = 0; i < 5; i = i + 1) Node(nil);\n");
+  heap().collect();
+
+  const auto& node = profile->kinds().at("Instance of Class Node");
+  EXPECT_EQ(node.objects, 15);
+  EXPECT_EQ(node.liveObjects, 10);
+  EXPECT_EQ(node.bytes, 15 * (node.liveBytes / 10));
+  EXPECT_GE(profile->lines().at(3).liveObjects, 10);
+  EXPECT_EQ(profile->lines().at(4).liveObjects, 0);
+  EXPECT_GE(profile->lines().at(4).objects, 5);
+  int snapshots = heap().stats().collections - collections;
+  EXPECT_EQ(profile->snapshots(), snapshots);
+
+  lox.stopHeapProfile();
+  EXPECT_EQ(heap().profile(), nullptr);
+  auto written = out.str();
+  EXPECT_NE(written.find("snapshot 1, collection "), std::string::npos);
+  EXPECT_NE(written.find("snapshot " + std::to_string(snapshots + 1) +
+                         ", exit: "),
+            std::string::npos);
+  EXPECT_NE(written.find("  Instance of Class Node\n"), std::string::npos)
+      << written;
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+
+#include "../src/Lox/Heap.h"
+#include "../src/Lox/lox.h"
+
+using lox::lang::Engine;
+using lox::lang::Heap;
+using lox::lang::Lox;
+
+constexpr std::string_view kCycles =
+    "class Node {\n"
+    "  init() { this.self = this; this.method = this.get; }\n"
+    "  get() { return this.self; }\n"
+    "}\n"
+    "fun churn() {\n"
+    "  for (var i = 0; i < 1000; i = i + 1) {\n"
+    "    var node = Node();\n"
+    "    fun walk(k) { if (k > 0) return walk(k - 1); return node; }\n"
+    "    walk(3);\n"
+    "  }\n"
+    "}\n"
+    "churn();\n"
+    "print \"done\";";
+// Operands come from variables, concatenating literals folds at compile time.
+constexpr std::string_view kGarbage =
+    "var x = \"x\";\n"
+    "var y = \"y\";\n"
+    "fun garbage() {\n"
+    "  for (var i = 0; i < 50000; i = i + 1) { var s = x + y; }\n"
+    "  return \"!\";\n"
+    "}\n"
+    "var a = \"a\";\n"
+    "var c = \"c\";\n"
+    "print (a + \"b\") + garbage();\n"
+    "fun pair(a, b) { return a + b; }\n"
+    "print pair(c + \"d\", garbage());";
+
+constexpr std::string_view kMethodCalls =
+    "class Counter {\n"
+    "  init() { this.count = 0; }\n"
+    "  add(n) { this.count = this.count + n; return this; }\n"
+    "}\n"
+    "var counter = Counter();\n"
+    "for (var i = 0; i < 1000; i = i + 1) counter.add(i).add(1);\n"
+    "print counter.count;";
+
+constexpr std::string_view kPlainCalls =
+    "fun fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+    "print fib(20);";
+
+class HeapTests : public testing::TestWithParam<Engine> {
+ protected:
+  std::string run(Lox& lox, std::string_view code) {
+    testing::internal::CaptureStdout();
+    lox.run(std::string{code});
+    return testing::internal::GetCapturedStdout();
+  }
+};
+
+TEST_P(HeapTests, TestCyclesAreCollected) {
+  auto& heap = lox::lang::heap();
+  auto lox = Lox(GetParam());
+  heap.collect();
+  auto live = heap.liveObjects();
+  auto freed = heap.stats().objectsFreed;
+
+  EXPECT_EQ(run(lox, kCycles), "[Out]: done\n");
+  heap.collect();
+  EXPECT_GT(heap.stats().objectsFreed - freed, 1000);
+  // Only the class, the function and the literals of the script survive.
+  EXPECT_LT(heap.liveObjects(), live + 50);
+}
+
+TEST_P(HeapTests, TestTemporariesSurviveCollections) {
+  auto& heap = lox::lang::heap();
+  auto lox = Lox(GetParam());
+  auto collections = heap.stats().collections;
+
+  EXPECT_EQ(run(lox, kGarbage), "[Out]: ab!\n[Out]: cd!\n");
+  EXPECT_GT(heap.stats().collections, collections);
+}
+
+TEST_P(HeapTests, TestMethodCallsDoNotBind) {
+  auto& heap = lox::lang::heap();
+  auto lox = Lox(GetParam());
+  auto allocated = heap.stats().objectsAllocated;
+
+  EXPECT_EQ(run(lox, kMethodCalls), "[Out]: 500500.000000\n");
+  // The class, its methods and the instance, no bound methods.
+  EXPECT_LE(heap.stats().objectsAllocated - allocated, 50);
+}
+
+TEST_P(HeapTests, TestCallsWithoutCapturesDoNotAllocate) {
+  auto& heap = lox::lang::heap();
+  auto lox = Lox(GetParam());
+  auto allocated = heap.stats().objectsAllocated;
+
+  EXPECT_EQ(run(lox, kPlainCalls), "[Out]: 6765.000000\n");
+  // The function and the string of the output, none per call.
+  EXPECT_LE(heap.stats().objectsAllocated - allocated, 10);
+}
+
+TEST(HeapTests, TestGrowthFactor) {
+  auto& heap = lox::lang::heap();
+  EXPECT_EQ(heap.growthFactor(), Heap::kDefaultGrowthFactor);
+  heap.setGrowthFactor(4.0);
+  EXPECT_EQ(heap.growthFactor(), 4.0);
+  heap.setGrowthFactor(Heap::kDefaultGrowthFactor);
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, HeapTests,
+                         testing::Values(Engine::TreeWalker, Engine::Bytecode));
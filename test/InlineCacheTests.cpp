@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+
+#include "../src/Lox/InlineCache.h"
+#include "../src/Lox/Shape.h"
+#include "../src/Lox/lox.h"
+
+using lox::lang::CacheCounters;
+using lox::lang::Engine;
+using lox::lang::Lox;
+using lox::lang::PropertyCache;
+using lox::lang::Shape;
+
+constexpr std::string_view kMonomorphic =
+    "class Point {\n"
+    "  init(x) { this.x = x; }\n"
+    "  getX() { return this.x; }\n"
+    "}\n"
+    "var sum = 0;\n"
+    "for (var i = 0; i < 100; i = i + 1) {\n"
+    "  var p = Point(i);\n"
+    "  sum = sum + p.x + p.getX();\n"
+    "}\n"
+    "print sum;";
+constexpr std::string_view kPolymorphic =
+    "class A { name() { return \"A\"; } }\n"
+    "class B { name() { return \"B\"; } }\n"
+    "fun describe(o) { return o.name(); }\n"
+    "print describe(A()) + describe(B()) + describe(A());\n"
+    "var b = B();\n"
+    "b.name = \"field\";\n"
+    "print describe(B()) + b.name;";
+
+std::string run(std::string_view code) {
+  auto lox = Lox(Engine::TreeWalker);
+  testing::internal::CaptureStdout();
+  lox.run(std::string{code});
+  return testing::internal::GetCapturedStdout();
+}
+
+TEST(InlineCacheTests, TestEntries) {
+  CacheCounters counters;
+  PropertyCache cache(counters);
+  auto x = Shape::empty()->withField("x");
+  auto y = Shape::empty()->withField("y");
+
+  EXPECT_EQ(cache.find(x, 1), nullptr);
+  cache.add({x, 0, 0, nullptr, nullptr});
+  auto entry = cache.find(x, 2);
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->slot, 0);
+  EXPECT_EQ(cache.find(y, 2), nullptr);
+  EXPECT_EQ(counters.hits, 1);
+  EXPECT_EQ(counters.misses, 2);
+  EXPECT_DOUBLE_EQ(counters.hitRate(), 1.0 / 3);
+
+  for (int i = 0; i < PropertyCache::kEntries; i++) {
+    cache.add({y, 0, i, nullptr, nullptr});
+  }
+  EXPECT_EQ(cache.size(), PropertyCache::kEntries);
+}
+
+TEST(InlineCacheTests, TestMonomorphicSites) {
+  const auto& stats = lox::lang::inlineCacheStats();
+  auto getHits = stats.get.hits;
+  auto setHits = stats.set.hits;
+  auto invokeHits = stats.invoke.hits;
+
+  EXPECT_EQ(run(kMonomorphic), "[Out]: 9900.000000\n");
+  EXPECT_GE(stats.get.hits - getHits, 190);
+  EXPECT_GE(stats.set.hits - setHits, 99);
+  EXPECT_GE(stats.invoke.hits - invokeHits, 99);
+}
+
+TEST(InlineCacheTests, TestPolymorphicSites) {
+  EXPECT_EQ(run(kPolymorphic), "[Out]: ABA\n[Out]: Bfield\n");
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+
+#include "../src/Lox/Jit.h"
+#include "../src/Lox/lox.h"
+
+using lox::lang::Jit;
+using lox::lang::Lox;
+
+constexpr std::string_view kNumeric =
+    "fun fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+    "fun square(x) { return x * x; }\n"
+    "fun sum(n) {\n"
+    "  var s = 0;\n"
+    "  var i = 0;\n"
+    "  while (true) {\n"
+    "    i = i + 1;\n"
+    "    if (i == 3 or i == 5) continue;\n"
+    "    if (!(i <= n)) break;\n"
+    "    s = s + (i >= 4 and i != 6 ? square(i) : -i / 2);\n"
+    "  }\n"
+    "  return s;\n"
+    "}\n"
+    "fun compare(a, b) { return a == b ? 1 : (a < b ? 2 : (a > b ? 3 : 4)); }\n"
+    "for (var i = 0; i < 3; i = i + 1) {\n"
+    "  print fib(15 + i);\n"
+    "  print sum(10 + i);\n"
+    "  print compare(i, 1);\n"
+    "  print compare(1, 0 / 1 - i);\n"
+    "}\n";
+constexpr std::string_view kDivision =
+    "fun divide(a, b) { return a / b; }\n"
+    "print divide(1, 2);\n"
+    "print divide(3, 4);\n"
+    "print divide(1, 0);\n"
+    "print divide(5, 2);";
+constexpr std::string_view kRebinding =
+    "fun one() { return 1; }\n"
+    "fun ten() { return 10; }\n"
+    "fun next() { return one() + 1; }\n"
+    "print next();\n"
+    "print next();\n"
+    "one = ten;\n"
+    "print next();";
+constexpr std::string_view kArgumentTypes =
+    "fun add(a, b) { return a + b; }\n"
+    "print add(1, 2);\n"
+    "print add(3, 4);\n"
+    "print add(\"a\", \"b\");\n"
+    "print add(5, 6);";
+constexpr std::string_view kUnsupported =
+    "fun greet(name) { return \"hi \" + name; }\n"
+    "fun halve(n) { if (n > 1) return n / 2; }\n"
+    "fun count(n) { print n; return n; }\n"
+    "for (var i = 0; i < 2; i = i + 1) {\n"
+    "  print greet(\"bob\");\n"
+    "  print halve(i);\n"
+    "  count(i);\n"
+    "}";
+
+class JitTests : public testing::Test {
+ protected:
+  void SetUp() override {
+    if (!Jit::supported()) {
+      GTEST_SKIP() << "The JIT only supports x86-64 Linux.";
+    }
+  }
+
+  // Output of `code`, compiling functions after `threshold` calls.
+  std::string run(std::string_view code, uint32_t threshold = 1,
+                  int maxCallDepth = 0) {
+    auto lox = Lox();
+    lox.setJitThreshold(threshold);
+    if (maxCallDepth) {
+      lox.setMaxCallDepth(maxCallDepth);
+    }
+    testing::internal::CaptureStdout();
+    lox.run(std::string{code});
+    return testing::internal::GetCapturedStdout();
+  }
+};
+
+TEST_F(JitTests, TestMatchesInterpreter) {
+  auto interpreted = run(kNumeric, 0);
+  EXPECT_EQ(interpreted.find("[Out]: 610.000000\n"), 0);
+  EXPECT_EQ(run(kNumeric), interpreted);
+  EXPECT_EQ(run(kNumeric, 2), interpreted);
+}
+
+TEST_F(JitTests, TestDivisionByZeroBailsOut) {
+  auto output = run(kDivision);
+  EXPECT_EQ(output.find("[Out]: 0.500000\n[Out]: 0.750000\n"), 0);
+  EXPECT_NE(output.find("Second operand must be non-zero."),
+            std::string::npos);
+  EXPECT_NE(output.find("[Out]: 2.500000\n"), std::string::npos);
+}
+
+TEST_F(JitTests, TestRebindingCalleeBailsOut) {
+  EXPECT_EQ(run(kRebinding),
+            "[Out]: 2.000000\n[Out]: 2.000000\n[Out]: 11.000000\n");
+}
+
+TEST_F(JitTests, TestNonNumberArgumentsAreInterpreted) {
+  EXPECT_EQ(run(kArgumentTypes),
+            "[Out]: 3.000000\n[Out]: 7.000000\n[Out]: ab\n"
+            "[Out]: 11.000000\n");
+}
+
+TEST_F(JitTests, TestUnsupportedFunctionsAreInterpreted) {
+  EXPECT_EQ(run(kUnsupported), run(kUnsupported, 0));
+}
+
+TEST_F(JitTests, TestStackOverflow) {
+  auto output = run(
+      "fun depth(n) { if (n == 0) return 0; return depth(n - 1) + 1; }\n"
+      "print depth(2);\n"
+      "print depth(9);\n"
+      "print depth(10);",
+      1, 10);
+  EXPECT_EQ(output.find("[Out]: 2.000000\n[Out]: 9.000000\n"), 0);
+  EXPECT_NE(output.find("Stack overflow."), std::string::npos);
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "../src/Lox/LineProfile.h"
+#include "../src/Lox/lox.h"
+
+using lox::lang::LineProfile;
+using lox::lang::Lox;
+
+TEST(LineProfileTests, TestCountsStatementsAndCalls) {
+  auto lox = Lox();
+  lox.setJitThreshold(0);
+  lox.startLineProfile();
+  lox.run(
+      "fun add(a, b) {\n"
+      "  return a + b;\n"
+      "}\n"
+      "var sum = 0;\n"
+      "for (var i = 0; i < 10; i = i + 1) {\n"
+      "  sum = add(sum, i);\n"
+      "}\n");
+  std::ostringstream out;
+  lox.writeLineProfile(out, 10);
+  auto report = out.str();
+  EXPECT_NE(report.find("       2             10              0"),
+            std::string::npos)
+      << report;
+  EXPECT_NE(report.find("       6             10             10"),
+            std::string::npos)
+      << report;
+  EXPECT_NE(report.find("       4              1              0"),
+            std::string::npos)
+      << report;
+}
+
+TEST(LineProfileTests, TestOrdersByTime) {
+  LineProfile profile;
+  {
+    LineProfile::Scope outer(profile, 3, LineProfile::Kind::Statement);
+    {
+      LineProfile::Scope inner(profile, 7, LineProfile::Kind::Call);
+      LineProfile::Scope again(profile, 3, LineProfile::Kind::Statement);
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+  }
+  { LineProfile::Scope once(profile, 5, LineProfile::Kind::Statement); }
+
+  // Line 3 encloses line 7, so it ran at least as long.
+  auto lines = profile.hottest(3);
+  ASSERT_EQ(lines.size(), 3);
+  EXPECT_EQ(lines[0].line, 3);
+  EXPECT_EQ(lines[0].executions, 2);
+  EXPECT_EQ(lines[0].calls, 0);
+  EXPECT_EQ(lines[0].active, 0);
+  for (const auto& line : lines) {
+    EXPECT_LE(line.time, lines[0].time);
+    if (line.line == 7) {
+      EXPECT_EQ(line.calls, 1);
+      EXPECT_EQ(line.executions, 0);
+    }
+  }
+  EXPECT_EQ(profile.hottest(1).size(), 1);
+}
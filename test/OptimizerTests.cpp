@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../src/Lox/Arena.h"
+#include "../src/Lox/AstPrinter.h"
+#include "../src/Lox/Optimizer.h"
+#include "../src/Lox/Parser.h"
+#include "../src/Lox/Scanner.h"
+
+using lox::lang::Optimizer;
+using lox::parser::Arena;
+using lox::parser::AstPrinter;
+using lox::parser::Parser;
+using lox::parser::Scanner;
+
+class OptimizerTests : public testing::Test {
+ protected:
+  // Optimized form of the only statement of `code`.
+  std::string optimize(std::string_view code) {
+    auto scanner = Scanner(code);
+    auto statements = Parser(scanner, arena_).parse();
+    Optimizer(arena_).optimize(statements);
+    EXPECT_EQ(statements.size(), 1);
+    return AstPrinter().print(statements[0]);
+  }
+
+ private:
+  Arena arena_;
+};
+
+TEST_F(OptimizerTests, TestFoldsOperators) {
+  EXPECT_EQ(optimize("print 60 * 60 * 24;"), "(print 86400.000000)");
+  EXPECT_EQ(optimize("print -(1 + 2) * 2;"), "(print -6.000000)");
+  EXPECT_EQ(optimize("print \"a\" + \"b\" + 1;"), "(print ab1.000000)");
+  EXPECT_EQ(optimize("print 1 < 2 == !nil;"), "(print true)");
+  EXPECT_EQ(optimize("print a + 2 * 3;"), "(print ( + a 6.000000))");
+}
+
+TEST_F(OptimizerTests, TestKeepsRuntimeErrors) {
+  EXPECT_EQ(optimize("print 1 / 0;"), "(print ( / 1.000000 0.000000))");
+  EXPECT_EQ(optimize("print 1 + nil;"), "(print ( + 1.000000 nil))");
+  EXPECT_EQ(optimize("print \"a\" * 2;"), "(print ( * a 2.000000))");
+}
+
+TEST_F(OptimizerTests, TestFoldsLogicalOperators) {
+  EXPECT_EQ(optimize("print false and a;"), "(print false)");
+  EXPECT_EQ(optimize("print 1 or a;"), "(print true)");
+  EXPECT_EQ(optimize("print nil or \"x\";"), "(print true)");
+  EXPECT_EQ(optimize("print true and a;"), "(print ( and true a))");
+}
+
+TEST_F(OptimizerTests, TestFoldsConditions) {
+  EXPECT_EQ(optimize("print 0 ? a : b;"), "(print b)");
+  EXPECT_EQ(optimize("print \"\" ? a;"), "(print nil)");
+  EXPECT_EQ(optimize("if (2 > 1) print a; else print b;"), "(print a)");
+  EXPECT_EQ(optimize("if (false) print a;"), "{ \n}");
+  EXPECT_EQ(optimize("while (nil) print a;"), "{ \n}");
+  EXPECT_EQ(optimize("for (;;) print a;"), "(while (true) {(print a)}");
+}
@@ -18,14 +18,16 @@ auto printer = AstPrinter();
 
 TEST(ParserTests, TestEmptyTokens) {
   Tokens tokens = {{TT::END, 0}};
-  auto p = Parser(tokens);
+  Arena arena;
+  auto p = Parser(tokens, arena);
   auto stmts = p.parse();
   EXPECT_FALSE(stmts.size());
 }
 
 TEST(ParserTests, TestPrimaryFalse) {
   Tokens tokens = {{TT::FALSE, "false", 0}, {TT::SEMICOLON, 0}, {TT::END, 0}};
-  auto p = Parser(tokens);
+  Arena arena;
+  auto p = Parser(tokens, arena);
   auto stmts = p.parse();
   EXPECT_TRUE(stmts.size() == 1);
   EXPECT_EQ(printer.print(stmts[0]), "(false)");
@@ -33,7 +35,8 @@ TEST(ParserTests, TestPrimaryFalse) {
 
 TEST(ParserTests, TestPrimaryTrue) {
   Tokens tokens = {{TT::TRUE, "true", 0}, {TT::SEMICOLON, 0}, {TT::END, 0}};
-  auto p = Parser(tokens);
+  Arena arena;
+  auto p = Parser(tokens, arena);
   auto stmts = p.parse();
   EXPECT_TRUE(stmts.size() == 1);
   EXPECT_EQ(printer.print(stmts[0]), "(true)");
@@ -41,7 +44,8 @@ TEST(ParserTests, TestPrimaryTrue) {
 
 TEST(ParserTests, TestPrimaryNil) {
   Tokens tokens = {{TT::NIL, "nil", 0}, {TT::SEMICOLON, 0}, {TT::END, 0}};
-  auto p = Parser(tokens);
+  Arena arena;
+  auto p = Parser(tokens, arena);
   auto stmts = p.parse();
   EXPECT_TRUE(stmts.size() == 1);
   EXPECT_EQ(printer.print(stmts[0]), "(nil)");
@@ -49,7 +53,8 @@ TEST(ParserTests, TestPrimaryNil) {
 
 TEST(ParserTests, TestPrimaryNumber) {
   Tokens tokens = {{TT::NUMBER, "400", 0}, {TT::SEMICOLON, 0}, {TT::END, 0}};
-  auto p = Parser(tokens);
+  Arena arena;
+  auto p = Parser(tokens, arena);
   auto stmts = p.parse();
   EXPECT_TRUE(stmts.size() == 1);
   EXPECT_EQ(printer.print(stmts[0]), "(400.000000)");
@@ -60,7 +65,8 @@ TEST(ParserTests, TestPrimaryNumberPostfix) {
                    {TT::PLUS_PLUS, "++", 0},
                    {TT::SEMICOLON, 0},
                    {TT::END, 0}};
-  auto p = Parser(tokens);
+  Arena arena;
+  auto p = Parser(tokens, arena);
   auto stmts = p.parse();
   EXPECT_TRUE(stmts.size() == 1);
   EXPECT_EQ(printer.print(stmts[0]), "(( ++ 400.000000 ))");
@@ -68,7 +74,8 @@ TEST(ParserTests, TestPrimaryNumberPostfix) {
 
 TEST(ParserTests, TestPrimaryString) {
   Tokens tokens = {{TT::STRING, "str", 0}, {TT::SEMICOLON, 0}, {TT::END, 0}};
-  auto p = Parser(tokens);
+  Arena arena;
+  auto p = Parser(tokens, arena);
   auto stmts = p.parse();
   EXPECT_TRUE(stmts.size() == 1);
   EXPECT_EQ(printer.print(stmts[0]), "(\"str\")");
@@ -80,7 +87,8 @@ TEST(ParserTests, TestPrimaryGrouping) {
                    {TT::RIGHT_PAREN, ")", 0},
                    {TT::SEMICOLON, 0},
                    {TT::END, 0}};
-  auto p = Parser(tokens);
+  Arena arena;
+  auto p = Parser(tokens, arena);
   auto stmts = p.parse();
   EXPECT_TRUE(stmts.size() == 1);
   EXPECT_EQ(printer.print(stmts[0]), "(( \"str\" ))");
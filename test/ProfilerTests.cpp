@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/Lox/Arena.h"
+#include "../src/Lox/Parser.h"
+#include "../src/Lox/Profiler.h"
+#include "../src/Lox/Scanner.h"
+#include "../src/Lox/lox.h"
+
+using lox::lang::Lox;
+using lox::lang::Profiler;
+using lox::parser::Arena;
+using lox::parser::Function;
+using lox::parser::Parser;
+using lox::parser::Scanner;
+
+TEST(ProfilerTests, TestWritesCollapsedStacks) {
+  Arena arena;
+  auto scanner = Scanner("fun outer() {}\nfun inner() {}");
+  auto statements = Parser(scanner, arena).parse();
+  ASSERT_EQ(statements.size(), 2);
+  auto outer = dynamic_cast<const Function*>(statements[0]);
+  auto inner = dynamic_cast<const Function*>(statements[1]);
+
+  Profiler profiler;
+  profiler.record({outer, inner}, 3);
+  profiler.record({outer}, 1);
+  profiler.record({}, 2);
+  profiler.record({outer, inner}, 1);
+  profiler.record({outer}, 0);
+
+  std::ostringstream out;
+  profiler.write(out);
+  EXPECT_EQ(out.str(),
+            "<script> 2\n"
+            "<script>;outer:1 1\n"
+            "<script>;outer:1;inner:2 4\n");
+  EXPECT_EQ(profiler.samples(), 7);
+}
+
+TEST(ProfilerTests, TestSamplesRunningScript) {
+  auto lox = Lox();
+  lox.setJitThreshold(0);
+  lox.startProfiling(1000);
+  lox.run(
+      "fun spin(n) {\n"
+      "  var i = 0;\n"
+      "  while (i < n) i = i + 1;\n"
+      "  return i;\n"
+      "}\n"
+      "fun work() { return spin(2000000); }\n"
+      "var result = work();");
+  std::ostringstream out;
+  lox.writeProfile(out);
+  EXPECT_NE(out.str().find("<script>;work:6;spin:1 "), std::string::npos)
+      << out.str();
+}
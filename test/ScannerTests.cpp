@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 
+#include <string>
 #include <string_view>
+#include <vector>
 
 #include "../src/Lox/Scanner.h"
 
@@ -12,6 +14,7 @@ constexpr std::string_view kStringEmpty = "";
 constexpr std::string_view kStringEscapeCharacters = "\\\"\\t\\n";
 constexpr std::string_view kStringUnterminated = "unterminated string";
 constexpr std::string_view kLiteral = "name123";
+constexpr std::string_view kNameIdentifier = "name";
 constexpr std::string_view kArithmeticExpression = "1 + 2 - 3 * 4 / ( 5  + 6 )";
 constexpr std::string_view kLogicalExpression = "a == b and c != d or e > !g";
 constexpr std::string_view kConditionExpression =
@@ -24,12 +27,14 @@ constexpr std::string_view kFunctionDefinition =
     "fun name(a, b) {\n  return a + b;\n}";
 constexpr std::string_view kSignleLineComment = "// comment should be ignored";
 constexpr std::string_view kMultiLineComment = "/* multi \n line \n comment */";
+constexpr std::string_view kKeywordsAndPrefixes =
+    "for fo form this th thistle t continue con";
 constexpr std::string_view kClassDefinition =
     "class Child < Parent {\ninit(name) {\n this.name = name; }\nname() {\n "
     "return this.name; }\n}";
 
 TEST(ScannerTests, TestNumberInt) {
-  auto s = lox::parser::Scanner(std::string{kNumberInt});
+  auto s = lox::parser::Scanner(kNumberInt);
   auto tokens = s.scanTokens();
   lox::parser::Token tok = tokens[0];
   EXPECT_EQ(tok.type, lox::parser::Token::TokenType::NUMBER);
@@ -38,7 +43,7 @@ TEST(ScannerTests, TestNumberInt) {
 }
 
 TEST(ScannerTests, TestNumberFloat) {
-  auto s = lox::parser::Scanner(std::string{kNumberFloat});
+  auto s = lox::parser::Scanner(kNumberFloat);
   auto tokens = s.scanTokens();
   lox::parser::Token tok = tokens[0];
   EXPECT_EQ(tok.type, lox::parser::Token::TokenType::NUMBER);
@@ -47,7 +52,7 @@ TEST(ScannerTests, TestNumberFloat) {
 }
 
 TEST(ScannerTests, TestNumberFloatPartial) {
-  auto s = lox::parser::Scanner(std::string{kNumberFloatPartial});
+  auto s = lox::parser::Scanner(kNumberFloatPartial);
   auto tokens = s.scanTokens();
   lox::parser::Token tok = tokens[0];
   EXPECT_EQ(tok.type, lox::parser::Token::TokenType::NUMBER);
@@ -56,7 +61,8 @@ TEST(ScannerTests, TestNumberFloatPartial) {
 }
 
 TEST(ScannerTests, TestString) {
-  auto s = lox::parser::Scanner("\"" + std::string{kString} + "\"");
+  auto source = "\"" + std::string{kString} + "\"";
+  auto s = lox::parser::Scanner(source);
   auto tokens = s.scanTokens();
   lox::parser::Token tok = tokens[0];
   EXPECT_EQ(tok.type, lox::parser::Token::TokenType::STRING);
@@ -65,7 +71,8 @@ TEST(ScannerTests, TestString) {
 }
 
 TEST(ScannerTests, TestEmptyString) {
-  auto s = lox::parser::Scanner("\"" + std::string{kStringEmpty} + "\"");
+  auto source = "\"" + std::string{kStringEmpty} + "\"";
+  auto s = lox::parser::Scanner(source);
   auto tokens = s.scanTokens();
   lox::parser::Token tok = tokens[0];
   EXPECT_EQ(tok.type, lox::parser::Token::TokenType::STRING);
@@ -74,8 +81,8 @@ TEST(ScannerTests, TestEmptyString) {
 }
 
 TEST(ScannerTests, TestEscapeCharacterString) {
-  auto s =
-      lox::parser::Scanner("\"" + std::string{kStringEscapeCharacters} + "\"");
+  auto source = "\"" + std::string{kStringEscapeCharacters} + "\"";
+  auto s = lox::parser::Scanner(source);
   auto tokens = s.scanTokens();
   lox::parser::Token tok = tokens[0];
   EXPECT_EQ(tok.type, lox::parser::Token::TokenType::STRING);
@@ -83,7 +90,8 @@ TEST(ScannerTests, TestEscapeCharacterString) {
 }
 
 TEST(ScannerTests, TestUnterminatedString) {
-  auto s = lox::parser::Scanner("\"" + std::string{kStringUnterminated});
+  auto source = "\"" + std::string{kStringUnterminated};
+  auto s = lox::parser::Scanner(source);
   auto tokens = s.scanTokens();
   lox::parser::Token tok = tokens[0];
   EXPECT_EQ(tok.type, lox::parser::Token::TokenType::STRING);
@@ -91,13 +99,13 @@ TEST(ScannerTests, TestUnterminatedString) {
 }
 
 TEST(ScannerTests, TestNoCode) {
-  auto s = lox::parser::Scanner(std::string{kStringEmpty});
+  auto s = lox::parser::Scanner(kStringEmpty);
   auto tokens = s.scanTokens();
   EXPECT_EQ(tokens.size(), 1);
 }
 
 TEST(ScannerTests, TestLiteral) {
-  auto s = lox::parser::Scanner(std::string{kLiteral});
+  auto s = lox::parser::Scanner(kLiteral);
   auto tokens = s.scanTokens();
   lox::parser::Token tok = tokens[0];
   EXPECT_EQ(tok.type, lox::parser::Token::TokenType::IDENTIFIER);
@@ -106,7 +114,7 @@ TEST(ScannerTests, TestLiteral) {
 }
 
 TEST(ScannerTests, TestArithmetics) {
-  auto s = lox::parser::Scanner(std::string{kArithmeticExpression});
+  auto s = lox::parser::Scanner(kArithmeticExpression);
   auto tokens = s.scanTokens();
   EXPECT_EQ(tokens.size(), 14);
   EXPECT_EQ(tokens[2].type, lox::parser::Token::TokenType::NUMBER);
@@ -115,7 +123,7 @@ TEST(ScannerTests, TestArithmetics) {
 }
 
 TEST(ScannerTests, TestLogicalExpression) {
-  auto s = lox::parser::Scanner(std::string{kLogicalExpression});
+  auto s = lox::parser::Scanner(kLogicalExpression);
   auto tokens = s.scanTokens();
   EXPECT_EQ(tokens.size(), 13);
   EXPECT_EQ(tokens[1].type, lox::parser::Token::TokenType::EQUAL_EQUAL);
@@ -124,13 +132,13 @@ TEST(ScannerTests, TestLogicalExpression) {
 }
 
 TEST(ScannerTests, TestConditionExpression) {
-  auto s = lox::parser::Scanner(std::string{kConditionExpression});
+  auto s = lox::parser::Scanner(kConditionExpression);
   auto tokens = s.scanTokens();
   EXPECT_EQ(tokens.size(), 10);
 }
 
 TEST(ScannerTests, TestTernaryExpression) {
-  auto s = lox::parser::Scanner(std::string{kTernaryExpression});
+  auto s = lox::parser::Scanner(kTernaryExpression);
   auto tokens = s.scanTokens();
   EXPECT_EQ(tokens.size(), 6);
   EXPECT_EQ(tokens[1].type, lox::parser::Token::TokenType::QUESTION);
@@ -138,20 +146,20 @@ TEST(ScannerTests, TestTernaryExpression) {
 }
 
 TEST(ScannerTests, TestForLoopExpression) {
-  auto s = lox::parser::Scanner(std::string{kForLoopExpression});
+  auto s = lox::parser::Scanner(kForLoopExpression);
   auto tokens = s.scanTokens();
   EXPECT_EQ(tokens.size(), 14);
   EXPECT_EQ(tokens[7].type, lox::parser::Token::TokenType::PLUS_PLUS);
 }
 
 TEST(ScannerTests, TestWhileLoopExpression) {
-  auto s = lox::parser::Scanner(std::string{kWhileLoopExpression});
+  auto s = lox::parser::Scanner(kWhileLoopExpression);
   auto tokens = s.scanTokens();
   EXPECT_EQ(tokens.size(), 9);
 }
 
 TEST(ScannerTests, TestFunctionDefinition) {
-  auto s = lox::parser::Scanner(std::string{kFunctionDefinition});
+  auto s = lox::parser::Scanner(kFunctionDefinition);
   auto tokens = s.scanTokens();
   EXPECT_EQ(tokens.size(), 15);
   EXPECT_EQ(tokens[0].type, lox::parser::Token::TokenType::FUN);
@@ -162,19 +170,49 @@ TEST(ScannerTests, TestFunctionDefinition) {
 }
 
 TEST(ScannerTests, TestSingleLineComment) {
-  auto s = lox::parser::Scanner(std::string{kSignleLineComment});
+  auto s = lox::parser::Scanner(kSignleLineComment);
   auto tokens = s.scanTokens();
   EXPECT_EQ(tokens.size(), 1);
 }
 
 TEST(ScannerTests, TestMultiLineComment) {
-  auto s = lox::parser::Scanner(std::string(kMultiLineComment));
+  auto s = lox::parser::Scanner(kMultiLineComment);
   auto tokens = s.scanTokens();
   EXPECT_EQ(tokens.size(), 1);
 }
 
 TEST(ScannerTests, TestClassDefinition) {
-  auto s = lox::parser::Scanner(std::string{kClassDefinition});
+  auto s = lox::parser::Scanner(kClassDefinition);
   auto tokens = s.scanTokens();
   EXPECT_EQ(tokens.size(), 29);
-}
\ No newline at end of file
+}
+TEST(ScannerTests, TestTokensViewSource) {
+  auto s = lox::parser::Scanner(kArithmeticExpression);
+  auto tokens = s.scanTokens();
+  lox::parser::Token tok = tokens[0];
+  EXPECT_EQ(tok.lexeme.data(), kArithmeticExpression.data());
+}
+
+TEST(ScannerTests, TestIdentifiersAreInterned) {
+  std::vector<lox::parser::Token> tokens;
+  {
+    auto source = std::string{"name == name"};
+    tokens = lox::parser::Scanner(source).scanTokens();
+  }
+  EXPECT_EQ(tokens[0].lexeme, kNameIdentifier);
+  EXPECT_EQ(tokens[0].lexeme.data(), tokens[2].lexeme.data());
+}
+
+TEST(ScannerTests, TestKeywordsAndPrefixes) {
+  using TT = lox::parser::Token::TokenType;
+  auto s = lox::parser::Scanner(kKeywordsAndPrefixes);
+  auto tokens = s.scanTokens();
+  std::vector<TT> types;
+  for (const auto& token : tokens) {
+    types.push_back(token.type);
+  }
+  EXPECT_EQ(types, (std::vector<TT>{TT::FOR, TT::IDENTIFIER, TT::IDENTIFIER,
+                                    TT::THIS, TT::IDENTIFIER, TT::IDENTIFIER,
+                                    TT::IDENTIFIER, TT::CONTINUE,
+                                    TT::IDENTIFIER, TT::END}));
+}
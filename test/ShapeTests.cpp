@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <string>
+
+#include "../src/Lox/LoxInstance.h"
+#include "../src/Lox/Shape.h"
+#include "../src/Lox/Token.h"
+
+using lox::lang::LoxInstance;
+using lox::lang::Shape;
+using lox::lang::Value;
+using lox::parser::Token;
+
+namespace {
+Token name(std::string_view lexeme) {
+  return Token(Token::TokenType::IDENTIFIER, lexeme, 1);
+}
+}  // namespace
+
+TEST(ShapeTests, TestTransitionsAreShared) {
+  auto x = Shape::empty()->withField("x");
+  auto xy = x->withField("y");
+  EXPECT_EQ(Shape::empty()->withField("x"), x);
+  EXPECT_EQ(x->withField("y"), xy);
+  EXPECT_NE(Shape::empty()->withField("y")->withField("x"), xy);
+
+  EXPECT_EQ(Shape::empty()->lookup("x"), -1);
+  EXPECT_EQ(xy->size(), 2);
+  EXPECT_EQ(xy->lookup("x"), 0);
+  EXPECT_EQ(xy->lookup("y"), 1);
+  EXPECT_EQ(xy->lookup("z"), -1);
+  EXPECT_EQ(xy->name(1), "y");
+}
+
+TEST(ShapeTests, TestManyFields) {
+  static const std::string names[] = {"a", "b", "c", "d", "e", "f",
+                                      "g", "h", "i", "j", "k", "l"};
+  Shape* shape = Shape::empty();
+  for (const auto& field : names) {
+    shape = shape->withField(field);
+  }
+  for (int i = 0; i < std::size(names); i++) {
+    EXPECT_EQ(shape->lookup(std::string(names[i])), i);
+  }
+  EXPECT_EQ(shape->lookup("m"), -1);
+}
+
+TEST(ShapeTests, TestInstancesShareShapes) {
+  LoxInstance first(nullptr);
+  LoxInstance second(nullptr);
+  EXPECT_EQ(first.shape(), Shape::empty());
+
+  first.set(name("x"), 1.0);
+  first.set(name("y"), 2.0);
+  second.set(name("x"), 3.0);
+  second.set(name("y"), 4.0);
+  second.set(name("x"), 5.0);
+  EXPECT_EQ(first.shape(), second.shape());
+  EXPECT_EQ(first.get(name("y")).asNumber(), 2.0);
+  EXPECT_EQ(second.get(name("x")).asNumber(), 5.0);
+}
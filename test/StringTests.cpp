@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "../src/Lox/Heap.h"
+#include "../src/Lox/LoxString.h"
+
+using lox::lang::concatenate;
+using lox::lang::heap;
+using lox::lang::kMinRopeLength;
+using lox::lang::LoxString;
+using lox::lang::makeObject;
+using lox::lang::strings;
+using lox::lang::Value;
+
+TEST(StringTests, TestInternReturnsOneStringPerContent) {
+  auto hello = strings().intern("hello");
+  auto world = strings().intern("world");
+  EXPECT_EQ(strings().intern(std::string("hel") + "lo"), hello);
+  EXPECT_NE(hello, world);
+  EXPECT_TRUE(hello->interned());
+  EXPECT_EQ(hello->hash(), lox::lang::hashString("hello"));
+  EXPECT_TRUE(Value(hello).equals(Value(strings().intern("hello"))));
+  EXPECT_FALSE(Value(hello).equals(Value(world)));
+}
+
+TEST(StringTests, TestComparesInternedAndOtherStrings) {
+  auto interned = strings().intern("lox");
+  auto made = makeObject<LoxString>("lox");
+  auto other = makeObject<LoxString>("xol");
+  EXPECT_FALSE(made->interned());
+  EXPECT_TRUE(Value(interned).equals(Value(made)));
+  EXPECT_TRUE(Value(made).equals(Value(interned)));
+  EXPECT_FALSE(Value(made).equals(Value(other)));
+
+  auto joined = concatenate(Value(interned), Value(1.5));
+  EXPECT_EQ(joined->value(), "lox1.500000");
+  EXPECT_FALSE(joined->interned());
+}
+
+TEST(StringTests, TestCollectorRemovesUnusedInternedStrings) {
+  heap().collect();
+  auto size = strings().size();
+  strings().intern("short lived");
+  EXPECT_EQ(strings().size(), size + 1);
+  heap().collect();
+  EXPECT_EQ(strings().size(), size);
+}
+
+TEST(StringTests, TestLongConcatenationsAreRopes) {
+  auto left = makeObject<LoxString>(std::string(200, 'a'));
+  auto shortJoin = concatenate(Value(left), Value(strings().intern("b")));
+  EXPECT_FALSE(shortJoin->isRope());
+
+  auto rope = concatenate(Value(left), Value(left));
+  ASSERT_TRUE(rope->isRope());
+  EXPECT_EQ(rope->length(), 400);
+  EXPECT_TRUE(Value(rope).isTruthy());
+  EXPECT_FALSE(Value(rope).equals(Value(shortJoin)));
+  EXPECT_TRUE(rope->isRope());
+
+  auto joined = concatenate(Value(rope), Value(7.0));
+  EXPECT_EQ(joined->value(), std::string(400, 'a') + "7.000000");
+  EXPECT_FALSE(joined->isRope());
+  EXPECT_TRUE(rope->isRope());
+  EXPECT_TRUE(Value(makeObject<LoxString>(std::string(400, 'a')))
+                  .equals(Value(rope)));
+  EXPECT_FALSE(rope->isRope());
+}
+
+TEST(StringTests, TestFlattensDeepRopes) {
+  Value text = makeObject<LoxString>(std::string(kMinRopeLength, '-'));
+  for (int i = 0; i < 100000; i++) {
+    text = concatenate(text, Value(strings().intern("x")));
+  }
+  auto rope = text.as<LoxString>();
+  EXPECT_TRUE(rope->isRope());
+  EXPECT_EQ(rope->value(), std::string(kMinRopeLength, '-') +
+                               std::string(100000, 'x'));
+}